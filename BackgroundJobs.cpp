@@ -0,0 +1,57 @@
+#include "BackgroundJobs.hpp"
+
+#include <exception>
+#include <iostream>
+
+BackgroundJobs::BackgroundJobs() {
+	worker = std::thread(&BackgroundJobs::worker_main, this);
+}
+
+BackgroundJobs::~BackgroundJobs() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	worker.join();
+}
+
+void BackgroundJobs::worker_main() {
+	std::unique_lock< std::mutex > lock(mutex);
+	while (true) {
+		wake.wait(lock, [this](){ return quit || !jobs.empty(); });
+		if (jobs.empty()) break; //(quit, with nothing left to do)
+
+		std::function< void() > fn;
+		std::swap(fn, jobs.front());
+		jobs.pop_front();
+		running = true;
+		lock.unlock();
+
+		try {
+			fn();
+		} catch (std::exception &e) {
+			std::cerr << "Background job failed: " << e.what() << std::endl;
+		} catch (...) {
+			std::cerr << "Background job failed." << std::endl;
+		}
+		fn = nullptr; //(anything the job captured goes away here, off the calling thread)
+
+		lock.lock();
+		running = false;
+		if (jobs.empty()) done.notify_all();
+	}
+}
+
+void BackgroundJobs::post(std::function< void() > const &job) {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		jobs.emplace_back(job);
+	}
+	wake.notify_all();
+}
+
+void BackgroundJobs::finish() {
+	std::unique_lock< std::mutex > lock(mutex);
+	done.wait(lock, [this](){ return jobs.empty() && !running; });
+}
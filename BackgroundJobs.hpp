@@ -0,0 +1,34 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+//BackgroundJobs runs low-priority jobs, one after another, on a worker thread of its own
+// (GameMode uses it to tear down the previous level's scene and to read level files ahead of time,
+// so neither happens during a frame).
+//Jobs must not touch anything the main or simulation thread is using; a job that throws is reported
+// on std::cerr and skipped.
+struct BackgroundJobs {
+	BackgroundJobs();
+	~BackgroundJobs(); //(runs any jobs still queued)
+
+	//queue 'job' to run after everything posted before it:
+	void post(std::function< void() > const &job);
+
+	//wait until every job posted so far has run:
+	void finish();
+
+	//internals:
+	void worker_main();
+
+	std::thread worker;
+	std::mutex mutex; //protects everything below
+	std::condition_variable wake; //signalled when a job is posted or on shutdown
+	std::condition_variable done; //signalled when the queue empties
+	bool quit = false;
+	bool running = false;
+	std::deque< std::function< void() > > jobs;
+};
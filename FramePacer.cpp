@@ -0,0 +1,166 @@
+#include "FramePacer.hpp"
+
+#include "draw_text.hpp"
+#include "draw_overlay.hpp"
+
+#include <SDL.h>
+
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+static double now() {
+	return std::chrono::duration< double >(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//blend a new sample into a running average:
+static void smooth(float *average, float sample) {
+	*average = (*average == 0.0f ? sample : *average + 0.1f * (sample - *average));
+}
+
+FramePacer::FramePacer() {
+	if (char const *queue = std::getenv("FRAME_QUEUE")) {
+		max_queued = uint32_t(std::max(1, std::atoi(queue)));
+	}
+	if (char const *cap = std::getenv("FRAME_CAP")) {
+		frame_cap = std::max(0.0f, float(std::atof(cap)));
+	}
+	show_stats = (std::getenv("FRAME_STATS") != nullptr);
+
+	if (std::getenv("NO_VSYNC")) {
+		vsync = false;
+		if (SDL_GL_SetSwapInterval(0) != 0) {
+			std::cerr << "NOTE: couldn't turn off vsync (" << SDL_GetError() << ")." << std::endl;
+		}
+	} else {
+		//Set VSYNC + Late Swap (prevents crazy FPS):
+		if (SDL_GL_SetSwapInterval(-1) != 0) {
+			std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
+			if (SDL_GL_SetSwapInterval(1) != 0) {
+				std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
+				vsync = false;
+			}
+		}
+	}
+
+	frame_start = now();
+	next_start = frame_start;
+}
+
+FramePacer::~FramePacer() {
+	for (auto const &frame : in_flight) {
+		glDeleteSync(frame.fence);
+	}
+}
+
+void FramePacer::begin_frame() {
+	double before = now();
+	if (!vsync && frame_cap > 0.0f) {
+		//sleep most of the way, then spin for the last bit (sleeps often overshoot by a millisecond or so):
+		double sleep_until = next_start - 0.002;
+		if (before < sleep_until) {
+			std::this_thread::sleep_for(std::chrono::duration< double >(sleep_until - before));
+		}
+		while (now() < next_start) {
+			std::this_thread::yield();
+		}
+	}
+
+	double start = now();
+	smooth(&wait_ms, float((start - before + retire_wait) * 1000.0));
+	retire_wait = 0.0;
+	float frame = float((start - frame_start) * 1000.0);
+	smooth(&frame_ms, frame);
+	if (transition_until != 0.0) {
+		transition_worst = std::max(transition_worst, frame);
+		if (start >= transition_until) {
+			switch_ms = transition_worst;
+			transition_until = 0.0;
+			if (show_stats) std::cout << "Level switch: longest frame " << switch_ms << " ms (averaging " << frame_ms << " ms)." << std::endl;
+		}
+	}
+	frame_start = start;
+	if (frame_cap > 0.0f) {
+		//(if a frame runs long, don't try to catch up by rushing the next few)
+		next_start = std::max(next_start + 1.0 / frame_cap, start);
+	}
+}
+
+void FramePacer::begin_transition() {
+	transition_until = frame_start + 0.5;
+	transition_worst = 0.0f;
+}
+
+void FramePacer::end_frame(double input_time) {
+	InFlight frame;
+	frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame.input_time = input_time;
+	in_flight.emplace_back(frame);
+
+	double before = now();
+	retire();
+	retire_wait = now() - before;
+	queued = uint32_t(in_flight.size());
+}
+
+void FramePacer::retire() {
+	while (!in_flight.empty()) {
+		InFlight const &oldest = in_flight.front();
+		GLenum status = glClientWaitSync(oldest.fence, 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED) {
+			if (in_flight.size() <= max_queued) break;
+			//too many frames queued; wait for this one:
+			status = glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+		}
+		if (status != GL_TIMEOUT_EXPIRED && status != GL_WAIT_FAILED) {
+			smooth(&latency_ms, float((now() - oldest.input_time) * 1000.0));
+		}
+		glDeleteSync(oldest.fence);
+		in_flight.pop_front();
+	}
+}
+
+void FramePacer::draw_stats(glm::uvec2 const &drawable_size) const {
+	//(the font only has letters and digits, so everything is whole milliseconds)
+	auto ms = [](float v) { return std::to_string(int32_t(v + 0.5f)) + " MS"; };
+	std::string lines[] = {
+		"FRAME " + ms(frame_ms),
+		"LATENCY " + ms(latency_ms),
+		"WAIT " + ms(wait_ms),
+		"QUEUED " + std::to_string(queued) + " OF " + std::to_string(max_queued),
+		"SWITCH " + ms(switch_ms),
+		(vsync ? std::string("VSYNC") : frame_cap > 0.0f ? "CAP " + std::to_string(int32_t(frame_cap)) : std::string("UNCAPPED")),
+	};
+
+	glViewport(0, 0, drawable_size.x, drawable_size.y);
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	float aspect = drawable_size.x / float(drawable_size.y);
+	float height = 0.04f;
+	float line = 1.5f * height;
+	glm::vec2 at = glm::vec2(-aspect + 0.05f, 0.95f - height);
+
+	float width = 0.0f;
+	for (auto const &text : lines) {
+		width = std::max(width, text_width(text, height));
+	}
+	static std::vector< OverlayVertex > backing; //(static to avoid re-allocating every frame)
+	backing.clear();
+	add_overlay_rect(&backing,
+		glm::vec2(at.x - 0.02f, at.y - line * (sizeof(lines) / sizeof(lines[0]) - 1) - 0.02f),
+		glm::vec2(at.x + width + 0.02f, at.y + height + 0.02f),
+		glm::u8vec4(0x00, 0x00, 0x00, 0xa0));
+	draw_overlay(backing);
+
+	for (auto const &text : lines) {
+		draw_text(text, at, height, glm::vec4(1.0f, 1.0f, 0.6f, 1.0f));
+		at.y -= line;
+	}
+
+	glDisable(GL_BLEND);
+}
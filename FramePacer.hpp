@@ -0,0 +1,73 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <deque>
+
+//FramePacer keeps the CPU from running ahead of the GPU (and the display), so input is gathered
+// as close as possible to when the frame showing its results is drawn:
+// - a fence is placed after every frame; before the next frame starts, FramePacer waits until no more
+//   than 'max_queued' frames are still unfinished on the GPU. (Otherwise drivers let the CPU
+//   queue up several frames, each adding a frame of input latency.)
+// - with vsync off, frames are limited to 'frame_cap' per second by waiting before input is gathered.
+// - the same fences measure the time from gathering input to the GPU finishing the frame that shows it.
+//
+//Configured from the environment:
+//  NO_VSYNC -- don't wait for vertical blank when swapping
+//  FRAME_CAP=<fps> -- frame rate limit when vsync is off (default: none)
+//  FRAME_QUEUE=<frames> -- frames the GPU may fall behind (default: 1)
+//  FRAME_STATS -- draw frame time, latency, and waiting over the game (see draw_stats)
+//
+//Usage (main loop):
+//  pacer.begin_frame(); //may wait
+//  ...gather input (at time t), update, draw...
+//  SDL_GL_SwapWindow(window);
+//  pacer.end_frame(t_of_input_drawn);
+struct FramePacer {
+	//sets the swap interval, so needs a current GL context:
+	FramePacer();
+	~FramePacer();
+
+	//wait until it's time to start the next frame (call just before gathering input):
+	void begin_frame();
+
+	//call after swapping; 'input_time' is when the input reflected in the frame was gathered
+	// (seconds on std::chrono::steady_clock's clock; see MouseInput::now):
+	void end_frame(double input_time);
+
+	//watch the frames around a level switch (call during the frame that made it): the longest frame from
+	// this one through the next half second is kept in 'switch_ms' (and printed to stdout with FRAME_STATS):
+	void begin_transition();
+
+	//draw the measurements below as text in the top left of the window:
+	void draw_stats(glm::uvec2 const &drawable_size) const;
+
+	bool vsync = true;
+	float frame_cap = 0.0f; //frames per second (0 = none); only used with vsync off
+	uint32_t max_queued = 1;
+	bool show_stats = false;
+
+	//measurements (milliseconds, smoothed over recent frames):
+	float frame_ms = 0.0f; //time between frames
+	float latency_ms = 0.0f; //input gathered -> GPU done drawing the frame that shows it
+	float wait_ms = 0.0f; //time spent waiting in begin_frame/end_frame
+	uint32_t queued = 0; //frames still unfinished on the GPU after the last end_frame
+	float switch_ms = 0.0f; //longest frame around the last level switch (not smoothed)
+
+	//internals:
+	struct InFlight {
+		GLsync fence = 0;
+		double input_time = 0.0;
+	};
+	std::deque< InFlight > in_flight;
+	double frame_start = 0.0; //when the current frame started (after begin_frame)
+	double next_start = 0.0; //earliest start for the next frame (with frame_cap)
+	double retire_wait = 0.0; //time end_frame spent waiting (counted in the next begin_frame's wait_ms)
+	double transition_until = 0.0; //(0 when not watching a level switch)
+	float transition_worst = 0.0f;
+
+	//pop finished frames (waiting for the oldest ones if more than max_queued remain):
+	void retire();
+};
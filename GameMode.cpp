@@ -4,20 +4,22 @@
 #include "Load.hpp"
 #include "MeshBuffer.hpp"
 #include "Save.hpp"
+#include "Quicksave.hpp"
 #include "Scene.hpp"
 #include "gl_errors.hpp" //helper for dumpping OpenGL error messages
 #include "check_fb.hpp" //helper for checking currently bound OpenGL framebuffer
 #include "read_chunk.hpp" //helper for reading a vector of structures from a file
 #include "data_path.hpp" //helper to get paths relative to executable
-#include "compile_program.hpp" //helper to compile opengl shader programs
+#include "shader_files.hpp" //helper to load (and hot-reload) opengl shader programs from dist/shaders
 #include "draw_text.hpp" //helper to... um.. draw text
 #include "load_save_png.hpp"
 #include "texture_program.hpp"
 #include "depth_program.hpp"
+#include "gpu_timer.hpp" //helper for timing sections of GPU work
+#include "uniform_blocks.hpp"
 
-#include "BasicLevel.hpp"
+#include "ScriptedLevel.hpp"
 #include "GarnishLevel.hpp"
-#include "OvenLevel.hpp"
 #include "MenuLevel.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
@@ -27,6 +29,8 @@
 #include <fstream>
 #include <map>
 #include <cstddef>
+#include <cmath>
+#include <cassert>
 #include <random>
 
 #define NUM_CLIPPING_VERTS 20
@@ -67,90 +71,101 @@ Load< GLuint > empty_vao(LoadTagDefault, [](){
 	return new GLuint(vao);
 });
 
-Load< GLuint > blur_program(LoadTagDefault, [](){
-	GLuint program = compile_program(
-		//this draws a triangle that covers the entire screen:
-		"#version 330\n"
-		"void main() {\n"
-		"	gl_Position = vec4(4 * (gl_VertexID & 1) - 1,  2 * (gl_VertexID & 2) - 1, 0.0, 1.0);\n"
-		"}\n"
-		,
-		//NOTE on reading screen texture:
-		//texelFetch() gives direct pixel access with integer coordinates, but accessing out-of-bounds pixel is undefined:
-		//	vec4 color = texelFetch(tex, ivec2(gl_FragCoord.xy), 0);
-		//texture() requires using [0,1] coordinates, but handles out-of-bounds more gracefully (using wrap settings of underlying texture):
-		//	vec4 color = texture(tex, gl_FragCoord.xy / textureSize(tex,0));
-
-		"#version 330\n"
-		"uniform sampler2D color_tex;\n"
-        "uniform sampler2D bloom_tex;\n"
-		"out vec4 fragColor;\n"
-		"void main() {\n"
-		"	vec2 at = (gl_FragCoord.xy - 0.5 * textureSize(bloom_tex, 0)) / textureSize(bloom_tex, 0).y;\n"
-		//make blur amount more near the edges and less in the middle:
-		"	float amt = 10;\n"//(0.01 * textureSize(bloom_tex,0).y) * max(0.0,(length(at) - 0.3)/0.2);\n"
-		//pick a vector to move in for blur using function inspired by:
-		//https://stackoverflow.com/questions/12964279/whats-the-origin-of-this-glsl-rand-one-liner
-		"	vec2 ofs = amt * normalize(vec2(\n"
-		"		fract(dot(gl_FragCoord.xy ,vec2(12.9898,78.233))),\n"
-		"		fract(dot(gl_FragCoord.xy ,vec2(96.3869,-27.5796)))\n"
-		"	));\n"
-		//do a four-pixel average to blur:
-		"	vec4 blur =\n"
-		"		+ 0.25 * texture(bloom_tex, (gl_FragCoord.xy + vec2(ofs.x,ofs.y)) / textureSize(bloom_tex, 0))\n"
-		"		+ 0.25 * texture(bloom_tex, (gl_FragCoord.xy + vec2(-ofs.y,ofs.x)) / textureSize(bloom_tex, 0))\n"
-		"		+ 0.25 * texture(bloom_tex, (gl_FragCoord.xy + vec2(-ofs.x,-ofs.y)) / textureSize(bloom_tex, 0))\n"
-		"		+ 0.25 * texture(bloom_tex, (gl_FragCoord.xy + vec2(ofs.y,-ofs.x)) / textureSize(bloom_tex, 0))\n"
-		"	;\n"
-        "   vec4 fragColor1 = texture(color_tex, (gl_FragCoord.xy) /     textureSize(color_tex, 0));\n"
-		"	fragColor = fragColor1 + 0.7f*vec4(blur.rgb, 1.0);\n" //blur;\n"
-//        "   fragColor = texelFetch(bloom_tex, ivec2(gl_FragCoord.xy), 0);\n"
-		"}\n"
-	);
+//Bloom is computed on a chain of successively half-sized textures:
+// (1) downsample: the glow buffer is thresholded and shrunk into the first level, then each level is shrunk into the next
+// (2) blur: every level gets a separable gaussian blur (horizontal pass into scratch, vertical pass back)
+// (3) upsample: starting from the smallest level, each level is added into the next-larger one
+// (4) composite: the scene is copied to the screen and the first level is added on top of it
+//Blurring small levels is cheap, and the sum of levels gives a wide, smooth glow.
+//
+//Only a few objects glow (Scene::Object::glows), so all of this work is scissored to a rectangle
+// around them (and skipped entirely when there aren't any on screen).
+
+//(the bloom programs all draw a full-screen triangle with dist/shaders/fullscreen.vert)
+
+//Uniform locations in bloom_downsample_program:
+GLint bloom_downsample_program_dst_size_vec2 = -1;
+GLint bloom_downsample_program_threshold_float = -1;
+
+Load< GLuint > bloom_downsample_program(LoadTagDefault, [](){
+	GLuint *ret = new GLuint(0);
+	load_program_files(ret, "fullscreen.vert", "bloom_downsample.frag", [](GLuint program){
+		bloom_downsample_program_dst_size_vec2 = glGetUniformLocation(program, "dst_size");
+		bloom_downsample_program_threshold_float = glGetUniformLocation(program, "threshold");
+
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "src_tex"), 0);
+		glUseProgram(0);
+	});
+	return ret;
+});
 
-	glUseProgram(program);
+//Uniform locations in bloom_blur_program:
+GLint bloom_blur_program_dst_size_vec2 = -1;
+GLint bloom_blur_program_direction_vec2 = -1;
+GLint bloom_blur_program_wide_bool = -1;
+
+Load< GLuint > bloom_blur_program(LoadTagDefault, [](){
+	GLuint *ret = new GLuint(0);
+	load_program_files(ret, "fullscreen.vert", "bloom_blur.frag", [](GLuint program){
+		bloom_blur_program_dst_size_vec2 = glGetUniformLocation(program, "dst_size");
+		bloom_blur_program_direction_vec2 = glGetUniformLocation(program, "direction");
+		bloom_blur_program_wide_bool = glGetUniformLocation(program, "wide");
+
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "src_tex"), 0);
+		glUseProgram(0);
+	});
+	return ret;
+});
 
+//Uniform locations in bloom_upsample_program:
+GLint bloom_upsample_program_dst_size_vec2 = -1;
 
-	glUniform1i(glGetUniformLocation(program, "color_tex"), 0);
-	glUniform1i(glGetUniformLocation(program, "bloom_tex"), 1);
+Load< GLuint > bloom_upsample_program(LoadTagDefault, [](){
+	GLuint *ret = new GLuint(0);
+	load_program_files(ret, "fullscreen.vert", "bloom_upsample.frag", [](GLuint program){
+		bloom_upsample_program_dst_size_vec2 = glGetUniformLocation(program, "dst_size");
 
-    glUseProgram(0);
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "src_tex"), 0);
+		glUseProgram(0);
+	});
+	return ret;
+});
 
-	return new GLuint(program);
+//Uniform locations in bloom_composite_program:
+GLint bloom_composite_program_dst_size_vec2 = -1;
+GLint bloom_composite_program_intensity_float = -1;
+GLint bloom_composite_program_src_scale_vec2 = -1;
+
+Load< GLuint > bloom_composite_program(LoadTagDefault, [](){
+	GLuint *ret = new GLuint(0);
+	load_program_files(ret, "fullscreen.vert", "bloom_composite.frag", [](GLuint program){
+		bloom_composite_program_dst_size_vec2 = glGetUniformLocation(program, "dst_size");
+		bloom_composite_program_intensity_float = glGetUniformLocation(program, "intensity");
+		bloom_composite_program_src_scale_vec2 = glGetUniformLocation(program, "src_scale");
+
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "bloom_tex"), 0);
+		glUseProgram(0);
+	});
+	return ret;
 });
 
-Load< GLuint > portal_depth_program(LoadTagDefault, [](){
-	GLuint program = compile_program(
-		//this draws a triangle that covers the entire screen:
-		"#version 330\n"
-		"uniform vec2 portalNorm;\n"
-		"uniform mat4 mv;\n"
-		"uniform mat4 cam_scale;\n"
-		"void main() {\n"
-		//"	gl_Position = vec4(4 * (gl_VertexID & 1) - 1,  2 * (gl_VertexID & 2) - 1, -1.0, 1.0);\n"
-		"	if (gl_VertexID < 4) {\n" // Clipping plane 1 (through portal)
-		"		vec4 pt = vec4(100000 * (2 * (gl_VertexID & 1) - 1), 0.0, 100000 * ((gl_VertexID & 2) - 1), 1.0);\n"
-		"		gl_Position = cam_scale * mv * pt;\n"
-		"	} else {\n"
-		"		int idx = gl_VertexID - 4;\n"
-		"		vec2 pt = vec2(mv * vec4(0.0, 0.0, 0.0, 1.0)) - portalNorm * 2.5;\n"
-		"   	vec2 par = vec2(-portalNorm.y, portalNorm.x) * 1000.0;\n"
-		"   	vec2 norm = portalNorm * 1000.0;\n"
-		"   	pt = pt - norm * (idx & 1) + par * ((idx & 2) - 1);\n"
-		"		gl_Position = cam_scale * vec4(pt, -1.0, 1.0);\n"
-		"		gl_Position.z = -1.0;\n"
-		"	}\n"
-		"}\n"
-		,
-
-		"#version 330\n"
-		"out vec4 fragColor;\n"
-		"void main() {\n"
-		"	fragColor = vec4(0.0, 1.0, 0.0, 0.0);\n"
-		"}\n"
-	);
+//Uniform locations in portal_depth_program:
+GLint portal_depth_program_portalNorm_vec2 = -1;
+GLint portal_depth_program_mv_mat4 = -1;
+GLint portal_depth_program_cam_scale_mat4 = -1;
 
-	return new GLuint(program);
+Load< GLuint > portal_depth_program(LoadTagDefault, [](){
+	GLuint *ret = new GLuint(0);
+	load_program_files(ret, "portal_depth.vert", "portal_depth.frag", [](GLuint program){
+		portal_depth_program_portalNorm_vec2 = glGetUniformLocation(program, "portalNorm");
+		portal_depth_program_mv_mat4 = glGetUniformLocation(program, "mv");
+		portal_depth_program_cam_scale_mat4 = glGetUniformLocation(program, "cam_scale");
+	});
+	return ret;
 });
 
 
@@ -212,43 +227,50 @@ Scene::Transform *p1_trans = nullptr;
 
 void GameMode::load_scene() {
 	{
-		// Initialize random gen
-		std::random_device r;
-		std::seed_seq seed{r(), r(), r(), r(), r(), r(), r(), r()};
-		std::mt19937 rnd{seed};
-		random_gen = rnd;
+		// Initialize random streams (derived from session seed so input replays are deterministic)
+		uint64_t scene_seed = (uint64_t(seed) << 32) | scene_loads;
+		random.spawn.seed(scene_seed, 1);
+		random.spice.seed(scene_seed, 2);
+		scene_loads += 1;
+	}
+
+	//the outgoing level's music fades under the new level's (see the end of this function):
+	bool crossfade = false;
+	if (current_level) {
+		current_level->fade_out(0.5f);
+		crossfade = true;
 	}
 
 	if (scene != nullptr) {
-		delete scene;
+		//(nothing else points into the old scene once these are cleared -- 'drawn' has its own copy -- so
+		// it can be freed on the background thread rather than by whoever called load_scene)
+		Scene *old = scene;
+		background.post([old](){ delete old; });
+		scene = nullptr;
 		foods.clear();
 		pots.clear();
+		players[0].vicinity.clear();
+		players[1].vicinity.clear();
 	}
+	particles.clear();
 
 	Scene *ret = new Scene();
 
 	//pre-build some program info (material) blocks to assign to each object:
 	Scene::Object::ProgramInfo texture_program_info;
-	texture_program_info.program = texture_program->program;
+	texture_program_info.program = &texture_program->program;
 	texture_program_info.vao = *meshes_for_texture_program;
-	texture_program_info.mvp_mat4  = texture_program->object_to_clip_mat4;
-	texture_program_info.mv_mat4x3 = texture_program->object_to_light_mat4x3;
-	texture_program_info.itmv_mat3 = texture_program->normal_to_light_mat3;
-    texture_program_info.set_uniforms = [](){
-        glUniform1f(texture_program->glow_amt_float, 0.0f);
-    };
+	texture_program_info.object_block = true;
 
 	texture_program_info.textures[0] = *white_tex;
 
-    Scene::Object::ProgramInfo portal_program_info = texture_program_info;
-    portal_program_info.set_uniforms = [](){
-        glUniform1f(texture_program->glow_amt_float, 1.0f);
-    };
+	Scene::Object::ProgramInfo portal_program_info = texture_program_info;
+	portal_program_info.glow_amt = 1.0f;
 
 	Scene::Object::ProgramInfo depth_program_info;
-	depth_program_info.program = depth_program->program;
+	depth_program_info.program = &depth_program->program;
 	depth_program_info.vao = *meshes_for_depth_program;
-	depth_program_info.mvp_mat4  = depth_program->object_to_clip_mat4;
+	depth_program_info.object_block = true;
 
 	// Adjust for veges
 	texture_program_info.vao = *vegetable_meshes_for_texture_program;
@@ -265,6 +287,10 @@ void GameMode::load_scene() {
 		obj->programs[Scene::Object::ProgramTypeShadow] = depth_program_info;
 
 		MeshBuffer::Mesh const &mesh = vegetable_meshes->lookup("Portal1");
+		obj->mesh_min = mesh.min;
+		obj->mesh_max = mesh.max;
+		obj->glows = true;
+		obj->moves = true;
 		obj->programs[Scene::Object::ProgramTypeDefault].start = mesh.start;
 		obj->programs[Scene::Object::ProgramTypeDefault].count = mesh.count;
 
@@ -278,6 +304,10 @@ void GameMode::load_scene() {
 		obj->programs[Scene::Object::ProgramTypeShadow] = depth_program_info;
 
 		MeshBuffer::Mesh const &mesh = vegetable_meshes->lookup("Portal2");
+		obj->mesh_min = mesh.min;
+		obj->mesh_max = mesh.max;
+		obj->glows = true;
+		obj->moves = true;
 		obj->programs[Scene::Object::ProgramTypeDefault].start = mesh.start;
 		obj->programs[Scene::Object::ProgramTypeDefault].count = mesh.count;
 
@@ -301,19 +331,31 @@ void GameMode::load_scene() {
 	cam_trans->position = glm::vec3(0,0,25);
 	cam_trans->rotation = glm::angleAxis(glm::radians(0.f), glm::vec3(1.0f, 0.0f, 0.0f));
 
+	{ // Spot light up and in front of the table (things cast shadows onto the wall behind them)
+		Scene::Transform *spot_trans = ret->new_transform();
+		spot = ret->new_lamp(spot_trans);
+		spot->type = Scene::Lamp::Spot;
+		spot->energy = glm::vec3(0.35f);
+		spot->fov = glm::radians(100.0f);
+		spot->clip_start = 20.0f;
+		spot->clip_end = 200.0f;
+
+		spot_trans->position = glm::vec3(-20.0f, 40.0f, 80.0f);
+		//(lamps point along their -z axis, just like cameras)
+		spot_trans->rotation = glm::quat_cast(glm::inverse(glm::lookAt(
+			spot_trans->position, glm::vec3(0.0f, -10.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)
+		)));
+	}
+
 
 	scene = ret;
 
 	switch(level) {
 	case 0:
-		// current_level = new BasicLevel(this, texture_program_info, depth_program_info);
-		current_level = std::make_shared< BasicLevel >(this, texture_program_info, depth_program_info);
-		scores[0] = 50;
+		current_level = std::make_shared< ScriptedLevel >(this, texture_program_info, depth_program_info, data_path("vegetables.level"));
 		break;
 	case 1:
-		// current_level = new OvenLevel(this, texture_program_info, depth_program_info);
-		current_level = std::make_shared< OvenLevel >(this, texture_program_info, depth_program_info);
-		scores[1] = 0;
+		current_level = std::make_shared< ScriptedLevel >(this, texture_program_info, depth_program_info, data_path("oven.level"));
 		break;
     case 2:
         // current_level = new GarnishLevel(this, texture_program_info,
@@ -329,10 +371,31 @@ void GameMode::load_scene() {
 		break;
 	}
 
+	if (crossfade && current_level->bgm) {
+		current_level->bgm->set_volume(0.0f, 0.0f);
+		current_level->bgm->set_volume(1.0f, 0.5f);
+	}
+
 	paused = false;
 }
 
 GameMode::GameMode() {
+	{ //pick a seed for this session:
+		std::random_device r;
+		seed = r();
+	}
+
+	if (std::getenv("NO_DYNAMIC_RESOLUTION")) {
+		resolution.dynamic = false;
+	}
+
+	//read level files now, in the background, so the first switch to a level doesn't wait on them:
+	// (assets are loaded before any mode is made, so this is safe off the main thread)
+	background.post([](){
+		ScriptedLevel::load_script(data_path("vegetables.level"));
+		ScriptedLevel::load_script(data_path("oven.level"));
+	});
+
 	//load_scene();
 
 	//SDL_SetRelativeMouseMode(SDL_TRUE);
@@ -358,10 +421,10 @@ bool GameMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 			show_pause_menu();
 		}else if(evt.key.keysym.scancode == SDL_SCANCODE_ESCAPE){
 
-			SDL_SetRelativeMouseMode(SDL_FALSE);
+			wanted_mouse_mode = MouseModeAbsolute;
 		} else if (evt.key.keysym.scancode == SDL_SCANCODE_P) {
 
-			SDL_SetRelativeMouseMode(SDL_TRUE);
+			wanted_mouse_mode = MouseModeRelative;
 		}
 	}
 
@@ -401,6 +464,9 @@ bool GameMode::handle_mouse_event(ManyMouseEvent const &event, glm::uvec2 const
 }
 
 void GameMode::update(float elapsed) {
+	//(draw blends from here to the state at the end of this tick)
+	scene->store_tick_state();
+
 	if (paused) return;
 	{ // Update portals
 		players[0].update(elapsed);
@@ -408,6 +474,7 @@ void GameMode::update(float elapsed) {
 	}
 
 	current_level->update(elapsed);
+	particles.update(elapsed);
 
 	players[0].rotate(elapsed * rot_speeds[0]);
 	players[1].rotate(elapsed * rot_speeds[1]);
@@ -525,6 +592,40 @@ void GameMode::update(float elapsed) {
 	}
 }
 
+//Rectangle of pixels [min, max), used to limit bloom work to the area around glowing objects:
+struct PixelRect {
+	glm::ivec2 min = glm::ivec2(0);
+	glm::ivec2 max = glm::ivec2(0);
+
+	bool empty() const { return min.x >= max.x || min.y >= max.y; }
+
+	//smallest rectangle containing both:
+	PixelRect merged(PixelRect const &other) const {
+		if (empty()) return other;
+		if (other.empty()) return *this;
+		PixelRect ret;
+		ret.min = glm::min(min, other.min);
+		ret.max = glm::max(max, other.max);
+		return ret;
+	}
+
+	//the same area in a target of size 'to' instead of 'from' (rounded outward, grown by 'border', clamped to 'to'):
+	PixelRect scaled(glm::uvec2 const &from, glm::uvec2 const &to, int32_t border) const {
+		if (empty()) return PixelRect();
+		glm::vec2 scale = glm::vec2(to) / glm::vec2(from);
+		PixelRect ret;
+		ret.min = glm::ivec2(glm::floor(glm::vec2(min) * scale)) - glm::ivec2(border);
+		ret.max = glm::ivec2(glm::ceil(glm::vec2(max) * scale)) + glm::ivec2(border);
+		ret.min = glm::max(ret.min, glm::ivec2(0));
+		ret.max = glm::min(ret.max, glm::ivec2(to));
+		return ret;
+	}
+
+	void scissor() const {
+		glScissor(min.x, min.y, max.x - min.x, max.y - min.y);
+	}
+};
+
 //GameMode will render to some offscreen framebuffer(s).
 //This code allocates and resizes them as needed:
 struct Framebuffers {
@@ -538,6 +639,20 @@ struct Framebuffers {
     //This framebuffer is used for bloom effects:
 	GLuint bloom_color_tex = 0;
 	GLuint bloom_fb = 0;
+	//bloom_color_tex is zero outside of this rectangle (it's only cleared and drawn to inside it):
+	PixelRect bloom_color_dirty;
+
+	//Bloom chain (see bloom_*_program above); level i is (size / divisor) / 2^i,
+	// and each level has a same-sized scratch target for the separable blur:
+	uint32_t bloom_levels = 0;
+	uint32_t bloom_divisor = 0;
+	glm::uvec2 bloom_chain_for_size = glm::uvec2(0,0); //'size' when the chain was built
+	std::vector< glm::uvec2 > bloom_level_size;
+	std::vector< GLuint > bloom_level_tex;
+	std::vector< GLuint > bloom_level_fb;
+	std::vector< GLuint > bloom_scratch_tex;
+	std::vector< GLuint > bloom_scratch_fb;
+	std::vector< PixelRect > bloom_level_dirty; //level (and scratch) textures are zero outside these
 
 	//This framebuffer is used for shadow maps:
 	glm::uvec2 shadow_size = glm::uvec2(0,0);
@@ -545,6 +660,14 @@ struct Framebuffers {
 	GLuint shadow_depth_tex = 0;
 	GLuint shadow_fb = 0;
 
+	//Shadow map of just the objects that don't move; copied into shadow_depth_tex every frame
+	// and only redrawn when the light or one of those objects changes (see draw_shadow_map):
+	GLuint static_shadow_depth_tex = 0;
+	GLuint static_shadow_fb = 0;
+	bool static_shadow_valid = false;
+	glm::mat4 static_shadow_world_to_clip = glm::mat4(1.0f); //light transform it was drawn with
+	uint64_t static_shadow_signature = 0; //static_shadow_signature() of the scene it was drawn from
+
 	void allocate(glm::uvec2 const &new_size, glm::uvec2 const &new_shadow_size) {
 		//allocate full-screen framebuffer:
 		if (size != new_size) {
@@ -562,8 +685,9 @@ struct Framebuffers {
             if (bloom_color_tex == 0) glGenTextures(1, &bloom_color_tex);
 			glBindTexture(GL_TEXTURE_2D, bloom_color_tex);
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, size.x, size.y, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			//(linear filtering because the bloom downsample pass relies on bilinear taps)
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 			glBindTexture(GL_TEXTURE_2D, 0);
@@ -581,6 +705,10 @@ struct Framebuffers {
             GLenum bufs[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
             glDrawBuffers(2, bufs);
 			check_fb();
+			//start with an all-zero glow buffer (see bloom_color_dirty):
+			GLfloat zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			glClearBufferfv(GL_COLOR, 1, zero);
+			bloom_color_dirty = PixelRect();
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
             if (bloom_fb == 0) glGenFramebuffers(1, &bloom_fb);
@@ -614,6 +742,18 @@ struct Framebuffers {
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			//(sampled as a sampler2DShadow, so lookups return depth comparisons -- with free 2x2 PCF from LINEAR filtering)
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			if (static_shadow_depth_tex == 0) glGenTextures(1, &static_shadow_depth_tex);
+			glBindTexture(GL_TEXTURE_2D, static_shadow_depth_tex);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, shadow_size.x, shadow_size.y, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 			glBindTexture(GL_TEXTURE_2D, 0);
 
 			if (shadow_fb == 0) glGenFramebuffers(1, &shadow_fb);
@@ -623,22 +763,415 @@ struct Framebuffers {
 			check_fb();
 			glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+			if (static_shadow_fb == 0) glGenFramebuffers(1, &static_shadow_fb);
+			glBindFramebuffer(GL_FRAMEBUFFER, static_shadow_fb);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, static_shadow_depth_tex, 0);
+			//depth only:
+			GLenum none = GL_NONE;
+			glDrawBuffers(1, &none);
+			glReadBuffer(GL_NONE);
+			check_fb();
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			static_shadow_valid = false;
+
 			GL_ERRORS();
 		}
 	}
+
+	//(re-)build bloom chain if the screen size or settings changed (call after allocate):
+	void allocate_bloom(uint32_t levels, uint32_t divisor) {
+		divisor = std::max(1U, divisor);
+		if (bloom_chain_for_size == size && bloom_levels == levels && bloom_divisor == divisor) return;
+		bloom_chain_for_size = size;
+		bloom_levels = levels;
+		bloom_divisor = divisor;
+
+		if (!bloom_level_tex.empty()) {
+			glDeleteTextures(GLsizei(bloom_level_tex.size()), bloom_level_tex.data());
+			glDeleteFramebuffers(GLsizei(bloom_level_fb.size()), bloom_level_fb.data());
+			glDeleteTextures(GLsizei(bloom_scratch_tex.size()), bloom_scratch_tex.data());
+			glDeleteFramebuffers(GLsizei(bloom_scratch_fb.size()), bloom_scratch_fb.data());
+		}
+		bloom_level_size.clear();
+		bloom_level_tex.clear();
+		bloom_level_fb.clear();
+		bloom_scratch_tex.clear();
+		bloom_scratch_fb.clear();
+
+		auto make_target = [](glm::uvec2 const &target_size, std::vector< GLuint > *texs, std::vector< GLuint > *fbs) {
+			GLuint tex = 0;
+			glGenTextures(1, &tex);
+			glBindTexture(GL_TEXTURE_2D, tex);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, target_size.x, target_size.y, 0, GL_RGB, GL_FLOAT, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			GLuint fb = 0;
+			glGenFramebuffers(1, &fb);
+			glBindFramebuffer(GL_FRAMEBUFFER, fb);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+			check_fb();
+			GLfloat zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			glClearBufferfv(GL_COLOR, 0, zero);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+			texs->emplace_back(tex);
+			fbs->emplace_back(fb);
+		};
+
+		glm::uvec2 level_size = glm::max(size / divisor, glm::uvec2(1));
+		for (uint32_t i = 0; i < std::max(1U, levels); ++i) {
+			bloom_level_size.emplace_back(level_size);
+			make_target(level_size, &bloom_level_tex, &bloom_level_fb);
+			make_target(level_size, &bloom_scratch_tex, &bloom_scratch_fb);
+			if (level_size.x <= 2 || level_size.y <= 2) break; //no point in going smaller
+			level_size = glm::max(level_size / 2U, glm::uvec2(1));
+		}
+		bloom_level_dirty.assign(bloom_level_tex.size(), PixelRect());
+
+		GL_ERRORS();
+	}
 } fbs;
 
+//find the area of the screen covered by glowing objects (grown by 'pad' pixels):
+static PixelRect find_glow_rect(Scene const &scene, glm::mat4 const &world_to_clip, glm::uvec2 const &size, int32_t pad) {
+	glm::vec2 min = glm::vec2( std::numeric_limits< float >::infinity());
+	glm::vec2 max = glm::vec2(-std::numeric_limits< float >::infinity());
+	for (Scene::Object const *obj = scene.first_object; obj != nullptr; obj = obj->alloc_next) {
+		if (!obj->glows) continue;
+		glm::mat4 local_to_clip = world_to_clip * obj->transform->make_local_to_world();
+		for (uint32_t c = 0; c < 8; ++c) {
+			glm::vec4 corner = glm::vec4(
+				(c & 1 ? obj->mesh_max.x : obj->mesh_min.x),
+				(c & 2 ? obj->mesh_max.y : obj->mesh_min.y),
+				(c & 4 ? obj->mesh_max.z : obj->mesh_min.z),
+				1.0f
+			);
+			glm::vec4 clip = local_to_clip * corner;
+			if (clip.w <= 0.0f) {
+				//behind the camera; give up and use the whole screen:
+				min = glm::vec2(-1.0f);
+				max = glm::vec2(1.0f);
+				break;
+			}
+			glm::vec2 ndc = glm::vec2(clip) / clip.w;
+			min = glm::min(min, ndc);
+			max = glm::max(max, ndc);
+		}
+	}
+	if (!(min.x <= max.x)) return PixelRect(); //nothing glows
+
+	PixelRect ret;
+	ret.min = glm::ivec2(glm::floor((min * 0.5f + 0.5f) * glm::vec2(size))) - glm::ivec2(pad);
+	ret.max = glm::ivec2(glm::ceil((max * 0.5f + 0.5f) * glm::vec2(size))) + glm::ivec2(pad);
+	ret.min = glm::max(ret.min, glm::ivec2(0));
+	ret.max = glm::min(ret.max, glm::ivec2(size));
+	if (ret.empty()) return PixelRect(); //glowing things are off screen
+	return ret;
+}
+
+//fingerprint of everything that ends up in the static (cached) part of the shadow map:
+static uint64_t static_shadow_signature(Scene const &scene) {
+	uint64_t hash = 0xcbf29ce484222325ULL; //FNV-1a
+	auto add = [&hash](void const *data, size_t size) {
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ reinterpret_cast< uint8_t const * >(data)[i]) * 0x100000001b3ULL;
+		}
+	};
+	for (Scene::Object const *obj = scene.first_object; obj != nullptr; obj = obj->alloc_next) {
+		if (obj->moves) continue;
+		Scene::Object::ProgramInfo const &info = obj->programs[Scene::Object::ProgramTypeShadow];
+		if (info.program == nullptr) continue;
+		glm::mat4 local_to_world = obj->transform->make_local_to_world();
+		add(&obj->id, sizeof(obj->id));
+		add(info.program, sizeof(*info.program)); //(so a reloaded shadow program redraws the map)
+		add(&info.vao, sizeof(info.vao));
+		add(&info.start, sizeof(info.start));
+		add(&info.count, sizeof(info.count));
+		add(glm::value_ptr(local_to_world), sizeof(local_to_world));
+	}
+	return hash;
+}
+
+//render the shadow map for 'world_to_spot' into fbs.shadow_depth_tex:
+// objects that don't move are drawn into fbs.static_shadow_depth_tex only when they (or the light) change;
+// each frame that is copied over and the moving objects are drawn on top.
+static void draw_shadow_map(Scene const &scene, glm::mat4 const &world_to_spot) {
+	glViewport(0, 0, fbs.shadow_size.x, fbs.shadow_size.y);
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+	//push depths away from the light a bit to avoid self-shadowing ("shadow acne"):
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+
+	uint64_t signature = static_shadow_signature(scene);
+	if (!fbs.static_shadow_valid
+	 || fbs.static_shadow_signature != signature
+	 || fbs.static_shadow_world_to_clip != world_to_spot) {
+		glBindFramebuffer(GL_FRAMEBUFFER, fbs.static_shadow_fb);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		scene.draw_if(world_to_spot, Scene::Object::ProgramTypeShadow, [](Scene::Object const &obj) {
+			return !obj.moves;
+		});
+		fbs.static_shadow_valid = true;
+		fbs.static_shadow_signature = signature;
+		fbs.static_shadow_world_to_clip = world_to_spot;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbs.static_shadow_fb);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbs.shadow_fb);
+	glBlitFramebuffer(
+		0, 0, fbs.shadow_size.x, fbs.shadow_size.y,
+		0, 0, fbs.shadow_size.x, fbs.shadow_size.y,
+		GL_DEPTH_BUFFER_BIT, GL_NEAREST
+	);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, fbs.shadow_fb);
+	scene.draw_if(world_to_spot, Scene::Object::ProgramTypeShadow, [](Scene::Object const &obj) {
+		return obj.moves;
+	});
+
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	GL_ERRORS();
+}
+
+//run the bloom chain on fbs.bloom_color_tex inside 'glow_rect', leaving the result in fbs.bloom_level_tex[0]:
+static void draw_bloom_chain(GameMode::BloomSettings const &bloom, PixelRect const &glow_rect) {
+	uint32_t levels = uint32_t(fbs.bloom_level_tex.size());
+	glActiveTexture(GL_TEXTURE0);
+	glEnable(GL_SCISSOR_TEST);
+
+	//area to work on at each level (with a small border so bilinear taps near the edge read valid data):
+	std::vector< PixelRect > rects(levels);
+	for (uint32_t i = 0; i < levels; ++i) {
+		rects[i] = glow_rect.scaled(fbs.size, fbs.bloom_level_size[i], 2);
+	}
+
+	//(1) downsample (thresholding on the way into the first level):
+	GLfloat zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+	glUseProgram(*bloom_downsample_program);
+	for (uint32_t i = 0; i < levels; ++i) {
+		glm::uvec2 const &dst_size = fbs.bloom_level_size[i];
+		glViewport(0, 0, dst_size.x, dst_size.y);
+
+		//clear anything left from last time, so everything outside rects[i] reads as zero:
+		rects[i].merged(fbs.bloom_level_dirty[i]).scissor();
+		glBindFramebuffer(GL_FRAMEBUFFER, fbs.bloom_scratch_fb[i]);
+		glClearBufferfv(GL_COLOR, 0, zero);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbs.bloom_level_fb[i]);
+		glClearBufferfv(GL_COLOR, 0, zero);
+		fbs.bloom_level_dirty[i] = rects[i];
+
+		rects[i].scissor();
+		glBindTexture(GL_TEXTURE_2D, (i == 0 ? fbs.bloom_color_tex : fbs.bloom_level_tex[i-1]));
+		glUniform2f(bloom_downsample_program_dst_size_vec2, float(dst_size.x), float(dst_size.y));
+		glUniform1f(bloom_downsample_program_threshold_float, (i == 0 ? bloom.threshold : 0.0f));
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+
+	//(2) separable blur of every level:
+	glUseProgram(*bloom_blur_program);
+	glUniform1i(bloom_blur_program_wide_bool, bloom.wide_kernel ? 1 : 0);
+	for (uint32_t i = 0; i < levels; ++i) {
+		glm::uvec2 const &dst_size = fbs.bloom_level_size[i];
+		glViewport(0, 0, dst_size.x, dst_size.y);
+		rects[i].scissor();
+		glUniform2f(bloom_blur_program_dst_size_vec2, float(dst_size.x), float(dst_size.y));
+
+		glBindFramebuffer(GL_FRAMEBUFFER, fbs.bloom_scratch_fb[i]);
+		glBindTexture(GL_TEXTURE_2D, fbs.bloom_level_tex[i]);
+		glUniform2f(bloom_blur_program_direction_vec2, 1.0f, 0.0f);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, fbs.bloom_level_fb[i]);
+		glBindTexture(GL_TEXTURE_2D, fbs.bloom_scratch_tex[i]);
+		glUniform2f(bloom_blur_program_direction_vec2, 0.0f, 1.0f);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+
+	//(3) upsample, accumulating from the smallest level into the largest:
+	glUseProgram(*bloom_upsample_program);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	for (uint32_t i = levels - 1; i > 0; --i) {
+		glm::uvec2 const &dst_size = fbs.bloom_level_size[i-1];
+		glBindFramebuffer(GL_FRAMEBUFFER, fbs.bloom_level_fb[i-1]);
+		glViewport(0, 0, dst_size.x, dst_size.y);
+		rects[i-1].scissor();
+		glBindTexture(GL_TEXTURE_2D, fbs.bloom_level_tex[i]);
+		glUniform2f(bloom_upsample_program_dst_size_vec2, float(dst_size.x), float(dst_size.y));
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+	glDisable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glDisable(GL_SCISSOR_TEST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	GL_ERRORS();
+}
+
+//print average objects drawn/culled per frame every so often (if DRAW_STATS is set in the environment):
+static void report_draw_stats(Scene::DrawStats const &stats) {
+	static bool report = (std::getenv("DRAW_STATS") != nullptr);
+	if (!report) return;
+	static uint32_t frames = 0;
+	static uint64_t drawn = 0;
+	static uint64_t culled = 0;
+	frames += 1;
+	drawn += stats.drawn;
+	culled += stats.culled;
+	if (frames == 120) {
+		std::cout << "[draw] per frame (all passes): " << (drawn / float(frames)) << " objects drawn, " << (culled / float(frames)) << " culled" << std::endl;
+		frames = 0;
+		drawn = 0;
+		culled = 0;
+	}
+}
+
+//adjust resolution->scale toward the largest scale that keeps GPU time under resolution->target_ms:
+static void update_render_scale(GameMode::ResolutionSettings *resolution, GPUTimer const &scene_timer, GPUTimer const &post_timer) {
+	static bool report = (std::getenv("GPU_TIMERS") != nullptr);
+	static uint32_t last_results = 0;
+	if (!resolution->dynamic) return;
+	//only react to new results (they arrive a few frames late, and not every frame):
+	if (scene_timer.results == last_results) return;
+	last_results = scene_timer.results;
+	if (resolution->settle > 0) {
+		resolution->settle -= 1;
+		return;
+	}
+
+	float gpu_ms = std::max(scene_timer.last_ms + post_timer.last_ms, 0.01f);
+	float target_ms = resolution->target_ms;
+	//GPU time is mostly per-pixel work, so it goes roughly as scale^2:
+	float fit = resolution->scale * std::sqrt(target_ms / gpu_ms);
+	float scale = resolution->scale;
+	if (gpu_ms > target_ms) {
+		scale = fit; //over budget: drop right away
+	} else if (gpu_ms < 0.8f * target_ms) {
+		scale = std::min(fit, scale + 0.02f); //well under: creep back up, so as not to overshoot
+	}
+	scale = std::min(std::max(scale, resolution->min_scale), resolution->max_scale);
+	if (std::abs(scale - resolution->scale) < 0.01f) return;
+
+	resolution->scale = scale;
+	resolution->settle = GPUTimer::Ring; //(results already in flight were measured at the old scale)
+	if (report) {
+		std::cout << "[gpu] " << gpu_ms << "ms per frame; render scale now " << scale << std::endl;
+	}
+}
+
+//move a transform from in front of portal 'from' to the matching spot in front of portal 'to' (position and rotation only):
+static void move_through_portal(Scene::Transform *transform, Portal const &from, Portal const &to) {
+	// compute position along normal/parallel
+	vec2 from_par = vec2(-from.normal.y, from.normal.x);
+	vec2 to_par = vec2(-to.normal.y, to.normal.x);
+	vec2 pos_diff = glm::vec2(transform->position) - from.position;
+	float norm_diff = glm::dot(pos_diff, from.normal);
+	float par_diff = glm::dot(pos_diff, from_par);
+	// new position along new normal and parallel, in opposite direction
+	vec2 rotated_pos_diff = -norm_diff * to.normal - par_diff * to_par;
+	transform->position = glm::vec3(to.position + rotated_pos_diff, 0.0f);
+
+	// Rotate object to opposite new normal
+	float angle = atan2(-from.normal.x * to.normal.y + from.normal.y * to.normal.x, glm::dot(-to.normal, from.normal));
+	transform->rotation = angleAxis(angle, vec3(0,0,1)) * transform->rotation;
+}
+
+void GameMode::capture_draw_state() {
+	//copy the scene, then draw things where they are between the last two ticks:
+	drawn.scene.copy_from(*scene, &drawn.copies);
+	drawn.scene.interpolate(Mode::tick_alpha);
+
+	drawn.camera = drawn.copies.at(camera);
+	drawn.spot = drawn.copies.at(spot);
+
+	for (uint32_t i = 0; i < 2; ++i) {
+		Portal &p = drawn.portals[i];
+		p.portal_transform = drawn.copies.at(players[i].portal_transform);
+		p.position = glm::vec2(p.portal_transform->position); //(interpolated)
+		p.normal = players[i].normal;
+		p.speed = players[i].speed;
+		p.vicinity.clear();
+		for (Scene::Object *obj : players[i].vicinity) {
+			Scene::Object *copy = drawn.copies.at(obj);
+			copy->portal_in = &p;
+			p.vicinity.insert(copy);
+		}
+	}
+
+	drawn.level = current_level;
+	drawn.level->capture_draw_state();
+	drawn.sky_color = current_level->sky_color;
+	drawn.sky_direction = current_level->sky_direction;
+	drawn.level_index = level;
+	drawn.score = (level < scores.size() ? scores[level] : 0);
+	drawn.high_score = (level < high_scores.size() ? high_scores[level] : 0);
+
+	particles.capture_draw_state();
+}
+
 void GameMode::draw(glm::uvec2 const &drawable_size) {
+	if (!drawn.camera) return; //(nothing captured yet)
+	Scene &scene = drawn.scene;
+	Scene::Camera *camera = drawn.camera;
+	Scene::Lamp *spot = drawn.spot;
+	Portal *players = drawn.portals;
+
+	scene.draw_stats = Scene::DrawStats();
+
+	//GPU time for the scene (with bloom) and for the copy to the screen; together they drive resolution.scale:
+	static GPUTimer scene_timer("scene + bloom");
+	static GPUTimer post_timer("copy + composite");
+	scene_timer.collect();
+	post_timer.collect();
+	update_render_scale(&resolution, scene_timer, post_timer);
+
+	//the offscreen framebuffers stay window-sized; at reduced scale only their lower-left corner is drawn to:
 	fbs.allocate(drawable_size, glm::uvec2(512, 512));
+	glm::uvec2 render_size = glm::max(glm::uvec2(glm::round(glm::vec2(drawable_size) * resolution.scale)), glm::uvec2(1));
+	render_size = glm::min(render_size, drawable_size);
 	camera->aspect = drawable_size.x / float(drawable_size.y);
 
-	glViewport(0,0,drawable_size.x, drawable_size.y);
+	scene_timer.begin();
+
+	assert(spot && "load_scene() should have made a spot light");
+	glm::mat4 world_to_spot = spot->make_projection() * spot->transform->make_world_to_local();
+	draw_shadow_map(scene, world_to_spot);
+
+	glViewport(0, 0, render_size.x, render_size.y);
+
+	//figure out where (if anywhere) glowing objects are on screen, so bloom work can be limited to that area:
+	PixelRect glow_rect;
+	if (bloom.intensity > 0.0f) {
+		//pad by roughly how far the blur at the coarsest bloom level spreads light:
+		uint32_t coarsest_scale = std::max(1U, bloom.divisor) << (std::min(std::max(1U, bloom.levels), 16U) - 1);
+		int32_t pad = int32_t((bloom.wide_kernel ? 5 : 3) * coarsest_scale);
+		glm::mat4 world_to_clip = camera->make_projection() * camera->transform->make_world_to_local();
+		glow_rect = find_glow_rect(scene, world_to_clip, render_size, pad);
+	}
+	bool glowing = !glow_rect.empty();
 
 	glBindFramebuffer(GL_FRAMEBUFFER, fbs.fb);
 
+	//only write to the glow buffer when something glows:
+	GLenum bufs[2] = {GL_COLOR_ATTACHMENT0, GLenum(glowing ? GL_COLOR_ATTACHMENT1 : GL_NONE)};
+	glDrawBuffers(2, bufs);
+
     GLfloat black[4] = {0.0f, 0.0f, 0.0f, 0.0f};
     glClearBufferfv(GL_COLOR, 0, black);
-    glClearBufferfv(GL_COLOR, 1, black);
+	if (glowing) {
+		//clear the glow buffer where glow was drawn last time or may be drawn now (it's already zero elsewhere):
+		glEnable(GL_SCISSOR_TEST);
+		glow_rect.merged(fbs.bloom_color_dirty).scissor();
+		glClearBufferfv(GL_COLOR, 1, black);
+		glDisable(GL_SCISSOR_TEST);
+		fbs.bloom_color_dirty = glow_rect;
+	}
 	glClear(GL_DEPTH_BUFFER_BIT);
 
 	glEnable(GL_DEPTH_TEST);
@@ -646,43 +1179,56 @@ void GameMode::draw(glm::uvec2 const &drawable_size) {
 	glBlendEquation(GL_FUNC_ADD);
 	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	// Draw once for ambient light
-	glUseProgram(texture_program->program);
-
-	//don't use distant directional light at all (color == 0):
-	glUniform3fv(texture_program->sun_color_vec3, 1, glm::value_ptr(glm::vec3(0.0f, 0.0f, 0.0f)));
-	glUniform3fv(texture_program->sun_direction_vec3, 1, glm::value_ptr(glm::normalize(glm::vec3(0.0f, 0.0f,-1.0f))));
-	//little bit of ambient light:
-	glUniform3fv(texture_program->sky_color_vec3, 1, glm::value_ptr(glm::vec3(1.f,1.f,1.f)));
-	glUniform3fv(texture_program->sky_direction_vec3, 1, glm::value_ptr(glm::vec3(0.0f, 0.0f, 1.0f)));
+	{ //lighting (same for every object drawn this frame):
+		LightingBlock lighting;
+		//don't use distant directional light at all (color == 0):
+		lighting.sun_color = glm::vec3(0.0f, 0.0f, 0.0f);
+		lighting.sun_direction = glm::normalize(glm::vec3(0.0f, 0.0f,-1.0f));
+		//little bit of ambient light:
+		lighting.sky_color = drawn.sky_color;
+		lighting.sky_direction = drawn.sky_direction;
+
+		//shadowed spot light:
+		glm::mat4 spot_to_world = spot->transform->make_local_to_world();
+		lighting.spot_position = glm::vec3(spot_to_world[3]);
+		lighting.spot_direction = -glm::normalize(glm::vec3(spot_to_world[2]));
+		lighting.spot_color = spot->energy;
+		lighting.spot_outer_inner = glm::vec2(std::cos(0.5f * spot->fov), std::cos(0.4f * spot->fov));
+		//clip space [-1,1] to shadow map texture coordinates / depth [0,1]:
+		glm::mat4 clip_to_texture = glm::mat4(
+			0.5f, 0.0f, 0.0f, 0.0f,
+			0.0f, 0.5f, 0.0f, 0.0f,
+			0.0f, 0.0f, 0.5f, 0.0f,
+			0.5f, 0.5f, 0.5f, 1.0f
+		);
+		lighting.light_to_spot = clip_to_texture * world_to_spot;
+
+		upload_lighting(lighting);
+	}
 
-	glUniform3fv(texture_program->spot_color_vec3, 1, glm::value_ptr(glm::vec3(0.0f, 0.0f, 0.0f)));
+	//(Scene::draw leaves texture units that objects don't use alone, so this stays bound for all passes)
 	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindTexture(GL_TEXTURE_2D, fbs.shadow_depth_tex);
 	glActiveTexture(GL_TEXTURE0);
 
 	// Draw non-portalled things
-    scene->draw(camera, Scene::Object::ProgramTypeDefault, nullptr);
+    scene.draw(camera, Scene::Object::ProgramTypeDefault, nullptr);
 
-    auto draw_portal = [this](Portal &p) {
+    auto draw_portal = [&scene, camera](Portal &p) {
 		glUseProgram(*portal_depth_program);
 		glBindVertexArray(*empty_vao);
 		//glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 		glClear(GL_DEPTH_BUFFER_BIT);
 
-		static GLuint portal_norm = glGetUniformLocation(*portal_depth_program, "portalNorm");
-		static GLuint mv_mat4 = glGetUniformLocation(*portal_depth_program, "mv");
-		static GLuint cam_scale_mat4 = glGetUniformLocation(*portal_depth_program, "cam_scale");
-
 		glm::mat4 mv = p.portal_transform->make_local_to_world();
 
 		glm::mat4 cam_scale = camera->make_projection() * camera->transform->make_world_to_local();
 
 		//glm::vec2 pt = glm::vec2(mvp * glm::vec4(players[0].position, 0, 1));
 
-		glUniformMatrix4fv(mv_mat4, 1, GL_FALSE, glm::value_ptr(mv));
-		glUniformMatrix4fv(cam_scale_mat4, 1, GL_FALSE, glm::value_ptr(cam_scale));
-		glUniform2f(portal_norm, p.normal.x, p.normal.y);
+		glUniformMatrix4fv(portal_depth_program_mv_mat4, 1, GL_FALSE, glm::value_ptr(mv));
+		glUniformMatrix4fv(portal_depth_program_cam_scale_mat4, 1, GL_FALSE, glm::value_ptr(cam_scale));
+		glUniform2f(portal_depth_program_portalNorm_vec2, p.normal.x, p.normal.y);
 		//printf("%f, %f\n", p.normal.x, p.normal.y);
 
 		// Draw portal blocker
@@ -693,12 +1239,12 @@ void GameMode::draw(glm::uvec2 const &drawable_size) {
 
 
 		// Draw portalled things
-		scene->draw(camera, Scene::Object::ProgramTypeDefault, &p);
+		scene.draw(camera, Scene::Object::ProgramTypeDefault, &p);
 	};
 
 	{ // Move everthing from portal 1 to portal 0, then render from portal 0
 		for(Scene::Object * obj : players[1].vicinity) {
-			teleport(obj->transform, 0, false);
+			move_through_portal(obj->transform, players[1], players[0]);
 			obj->portal_in = &players[0];
 		}
 
@@ -707,31 +1253,89 @@ void GameMode::draw(glm::uvec2 const &drawable_size) {
 
 	{ // Move everything to portal 1 now and draw from there, then move to og
 		for(Scene::Object * obj : players[0].vicinity) {
-			teleport(obj->transform, 1, false);
+			move_through_portal(obj->transform, players[0], players[1]);
 			obj->portal_in = &players[1];
 		}
 		for(Scene::Object * obj : players[1].vicinity) {
-			teleport(obj->transform, 1, false);
+			move_through_portal(obj->transform, players[0], players[1]);
 			obj->portal_in = &players[1];
 		}
 
 		draw_portal(players[1]);
+	}
 
-		for(Scene::Object * obj : players[0].vicinity) {
-			teleport(obj->transform, 0, false);
-			obj->portal_in = &players[0];
-		}
+	{ //particles, over everything in the scene (the portal passes cleared depth, so no depth test):
+		glm::mat4 camera_to_world = camera->transform->make_local_to_world();
+		glm::mat4 world_to_clip = camera->make_projection() * camera->transform->make_world_to_local();
+		glDisable(GL_DEPTH_TEST);
+		glDepthMask(GL_FALSE);
+		particles.draw(world_to_clip, glm::normalize(glm::vec3(camera_to_world[0])), glm::normalize(glm::vec3(camera_to_world[1])));
+		glDepthMask(GL_TRUE);
+		glEnable(GL_DEPTH_TEST);
 	}
 
 	// extra rendering from level?
 	glUseProgram(texture_program->program);
-	current_level->render_pass();
+	drawn.level->render_pass();
+
+	GL_ERRORS();
+
+	//Copy scene from color buffer to screen, performing post-processing effects:
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+	glBindVertexArray(*empty_vao);
+
+	if (glowing) {
+		fbs.allocate_bloom(bloom.levels, bloom.divisor);
+		draw_bloom_chain(bloom, glow_rect);
+	}
 
-	if (level < 3) {
+	scene_timer.end();
+	post_timer.begin();
+
+	//copy scene to screen (stretching it to fit, if it was drawn at reduced resolution):
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbs.fb);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, render_size.x, render_size.y, 0, 0, drawable_size.x, drawable_size.y, GL_COLOR_BUFFER_BIT,
+		(render_size == drawable_size ? GL_NEAREST : GL_LINEAR));
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, drawable_size.x, drawable_size.y);
+
+	//add bloom on top:
+	if (glowing) {
+		glEnable(GL_SCISSOR_TEST);
+		glow_rect.scaled(render_size, drawable_size, 1).scissor();
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, fbs.bloom_level_tex[0]);
+		glUseProgram(*bloom_composite_program);
+		glUniform2f(bloom_composite_program_dst_size_vec2, float(drawable_size.x), float(drawable_size.y));
+		glUniform1f(bloom_composite_program_intensity_float, bloom.intensity);
+		glm::vec2 src_scale = glm::vec2(render_size) / glm::vec2(fbs.size);
+		glUniform2f(bloom_composite_program_src_scale_vec2, src_scale.x, src_scale.y);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_BLEND);
+		glDisable(GL_SCISSOR_TEST);
+	}
+
+	post_timer.end();
+
+	//text and meters, drawn at full resolution over the finished image:
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	drawn.level->render_overlay();
+
+	if (drawn.level_index < 3) {
 		glDisable(GL_DEPTH_TEST);
 
 		{ // draw score
-			std::string message = "SCORE "+std::to_string(scores[level]);
+			std::string message = "SCORE "+std::to_string(drawn.score);
 			float height = 0.05f;
 			float width = text_width(message, height);
 			draw_text(message, glm::vec2( 1.4f - width, 0.85f), height,
@@ -739,31 +1343,18 @@ void GameMode::draw(glm::uvec2 const &drawable_size) {
 		}
 
 		{ // draw high score
-			std::string message = "HIGH SCORE "+std::to_string(high_scores[level]);
+			std::string message = "HIGH SCORE "+std::to_string(drawn.high_score);
 			float height = 0.05f;
 			//float width = text_width(message, height);
 			draw_text(message, glm::vec2( -1.4f, 0.85f), height,
 					glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
 		}
-
-		glEnable(GL_DEPTH_TEST);
 	}
 
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
 
-	GL_ERRORS();
-
-	//Copy scene from color buffer to screen, performing post-processing effects:
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_BLEND);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, fbs.color_tex);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, fbs.bloom_color_tex);
-	glBindVertexArray(*empty_vao);
-    glUseProgram(*blur_program);
-	glDrawArrays(GL_TRIANGLES, 0, 3);
-
+	report_draw_stats(scene.draw_stats);
 
 	glUseProgram(0);
 	glActiveTexture(GL_TEXTURE0);
@@ -776,66 +1367,24 @@ void GameMode::teleport(Scene::Transform *object_transform, const uint32_t to_po
 	const Portal &  to_portal = players[ to_portal_id];
 
 	{  // compute new position and speed
-		// find angle between from_portal_normal and to_portal_normal (phi)
-		//                    from_portal_normal and    -object_speed (theta)
-		const glm::vec2 &from_normal = from_portal.normal;
-		const glm::vec2 &  to_normal =   to_portal.normal;
-		//object_transform->speed *= -1.0f;  // reverse speed
-
-		/*
-		auto angle_between = [=] (glm::vec2 from, glm::vec2 to) -> float {
-			from = glm::normalize(from);
-			to = glm::normalize(to);
-			float sign = (from.x*to.y - from.y*to.x > 0.0f) ? 1.0f : -1.0f;
-			return sign * std::acos(glm::dot(from, to));
-		};
-		float phi = angle_between(from_normal, to_normal);
-		float theta = angle_between(from_normal, object_transform->speed);
-		*/
-        // rotate position by phi
-		/*
-		glm::mat4 pos_rotation = glm::rotate(glm::mat4(1.f), phi, glm::vec3(0.0f, 0.0f, 1.0f));
-		auto pos_diff = glm::vec2(object_transform->position) - from_portal.position;
-		auto rotated_pos_diff = glm::vec2(pos_rotation * glm::vec4(pos_diff, 0.0f, 1.0f));
-		object_transform->position = glm::vec3(to_portal.position + rotated_pos_diff, 0.0f);
-		*/
-
-		// Instead, compute position along normal/parallel
-		vec2 from_par = vec2(-from_normal.y, from_normal.x);
-		vec2 to_par = vec2(-to_normal.y, to_normal.x);
-		vec2 pos_diff = glm::vec2(object_transform->position) - from_portal.position;
-		float norm_diff = glm::dot(pos_diff, from_normal);
-		float par_diff = glm::dot(pos_diff, from_par);
-		// new position along new normal and parallel, in opposite direction
-		vec2 rotated_pos_diff = -norm_diff * to_normal - par_diff * to_par;
-		object_transform->position = glm::vec3(to_portal.position + rotated_pos_diff, 0.0f);
-
-		// Rotate object to opposite new normal
-		float angle = atan2(-from_normal.x * to_normal.y + from_normal.y * to_normal.x, glm::dot(-to_normal, from_normal));
-		object_transform->rotation = angleAxis(angle, vec3(0,0,1)) * object_transform->rotation;
+		move_through_portal(object_transform, from_portal, to_portal);
 
 		if (update_speed) {
-			// rotate speed by phi - 2*theta
-			/*
-			glm::mat4 speed_rotation = glm::rotate(glm::mat4(1.f), phi - 2.0f*theta, glm::vec3(0.0f, 0.0f, 1.0f));
-			auto new_speed = glm::vec2(speed_rotation * glm::vec4(object_transform->speed, 0.0f, 1.0f));
-			// boost if new_speed is too slow
-			float speed_lowerbound = 5.0f;
-			object_transform->speed = (glm::length(new_speed) < speed_lowerbound) ?
-									speed_lowerbound * glm::normalize(object_transform->speed) :
-									new_speed;
-			*/
-
-			// Instead, compute speed along normal/parallel
+			// compute speed along normal/parallel
+			const glm::vec2 &from_normal = from_portal.normal;
+			const glm::vec2 &  to_normal =   to_portal.normal;
+			vec2 from_par = vec2(-from_normal.y, from_normal.x);
+			vec2 to_par = vec2(-to_normal.y, to_normal.x);
 			vec2 old_speed = object_transform->speed - from_portal.speed;
-			float norm_spd = glm::dot(old_speed, from_normal);// - glm::dot(from_portal.speed, from_normal);
-			float par_spd = glm::dot(old_speed, from_par);// - glm::dot(from_portal.speed, from_par);
+			float norm_spd = glm::dot(old_speed, from_normal);
+			float par_spd = glm::dot(old_speed, from_par);
 
-			// If too slow along normal, give boost
-			//if(norm_spd > -3.f) norm_spd = -3.f;
 			// new speed along new normal and parallel, in opposite direction
 			vec2 new_speed = -norm_spd * to_normal - par_spd * to_par;
 			object_transform->speed = new_speed + to_portal.speed;
+
+			//(don't draw it sliding across the screen from where it was last tick)
+			object_transform->skip_interpolation();
 		}
 	}
 
@@ -850,36 +1399,18 @@ void GameMode::show_pause_menu() {
 	//menu->background = game;
 
 	menu->choices.emplace_back("PAUSED");
-	menu->choices.emplace_back("SAVE STATE 1", [game, this](){
-			save(1,level, scores);
-			Mode::set_current(game);
-			});
-	menu->choices.emplace_back("SAVE STATE 2", [game, this](){
-			save(2,level, scores);
-			Mode::set_current(game);
-			});
-	menu->choices.emplace_back("SAVE STATE 3", [game, this](){
-			save(3,level, scores);
-			Mode::set_current(game);
-			});
-	menu->choices.emplace_back("LOAD STATE 1", [game, this](){
-			SaveData res = LoadSave(1);
-			level = res.currentLevel;
-			scores = res.personalBests;
-			Mode::set_current(game);
-			});
-	menu->choices.emplace_back("LOAD STATE 2", [game, this](){
-			SaveData res = LoadSave(2);
-			level = res.currentLevel;
-			scores = res.personalBests;
-			Mode::set_current(game);
-			});
-	menu->choices.emplace_back("LOAD STATE 3", [game, this](){
-			SaveData res = LoadSave(3);
-			level = res.currentLevel;
-			scores = res.personalBests;
-			Mode::set_current(game);
-			});
+	for (uint32_t slot = 1; slot <= 3; ++slot) {
+		menu->choices.emplace_back("SAVE STATE " + std::to_string(slot), [game, this, slot](){
+				save_state(slot);
+				Mode::set_current(game);
+				});
+	}
+	for (uint32_t slot = 1; slot <= 3; ++slot) {
+		menu->choices.emplace_back("LOAD STATE " + std::to_string(slot), [game, this, slot](){
+				load_state(slot);
+				Mode::set_current(game);
+				});
+	}
 	menu->choices.emplace_back("QUIT", [](){
 			Mode::set_current(nullptr);
 			});
@@ -889,6 +1420,30 @@ void GameMode::show_pause_menu() {
 	Mode::set_current(menu);
 }
 
+void GameMode::save_state(uint32_t slot) {
+	SaveData data = LoadSave(slot); //(keeps the personal bests)
+	data.currentLevel = level;
+	std::vector< uint8_t > game;
+	capture_quicksave(*this, &game);
+	data.set_chunk("game", game);
+	save(slot, data);
+}
+
+void GameMode::load_state(uint32_t slot) {
+	SaveData data = LoadSave(slot);
+	if (SaveData::Chunk const *game = data.find_chunk("game")) {
+		try {
+			restore_quicksave(this, game->data.data(), game->data.size());
+			return;
+		} catch (std::exception &e) {
+			std::cerr << "Couldn't restore state " << slot << ": " << e.what() << std::endl;
+		}
+	}
+	//no level in progress saved (e.g., a save from an older version), so start the saved level over:
+	level = data.currentLevel;
+	load_scene();
+}
+
 void GameMode::save_game() {
 	if (scores[level] > high_scores[level]) {
 		high_scores[level] = scores[level];
@@ -951,21 +1506,21 @@ void GameMode::show_level_select() {
 	menu->choices.emplace_back("SELECT LEVEL");
 	menu->choices.emplace_back("VEGETABLES", [this, game](){
 
-				SDL_SetRelativeMouseMode(SDL_TRUE);
+				wanted_mouse_mode = MouseModeRelative;
 				level = 0;
 				this->load_scene();
 				Mode::set_current(game);
 			});
 	menu->choices.emplace_back("OVEN", [this, game](){
 
-				SDL_SetRelativeMouseMode(SDL_TRUE);
+				wanted_mouse_mode = MouseModeRelative;
 				level = 1;
 				this->load_scene();
 				Mode::set_current(game);
 			});
     menu->choices.emplace_back("SPICEY", [this, game](){
 
-				SDL_SetRelativeMouseMode(SDL_TRUE);
+				wanted_mouse_mode = MouseModeRelative;
 				level = 2;
 				this->load_scene();
 				Mode::set_current(game);
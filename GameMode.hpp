@@ -16,6 +16,9 @@
 #include "manymouse/manymouse.h"
 #include "Portal.hpp"
 #include "Load.hpp"
+#include "ParticleSystem.hpp"
+#include "pcg32.hpp"
+#include "BackgroundJobs.hpp"
 
 // Forward declaration before including level
 struct GameMode;
@@ -37,12 +40,29 @@ struct GameMode : public Mode {
 	//update is called at the start of a new frame, after events are handled:
 	virtual void update(float elapsed) override;
 
-	//draw is called after update:
+	//draw is called after update (and only looks at 'drawn'):
 	virtual void draw(glm::uvec2 const &drawable_size) override;
 
+	virtual bool draws_from_capture() const override { return true; }
+	virtual void capture_draw_state() override;
+
+	//build the scene for 'level' (the old scene is freed on 'background', and the old level's music fades out):
+	// this runs on the calling thread -- for level switches that's the main thread, from a menu choice --
+	// so the new scene and level are built during that frame; only freeing and reading level files are kept off it.
 	void load_scene();
 
-	std::mt19937 random_gen;
+	//low-priority work kept off the frame (freeing old scenes, reading level files ahead of time):
+	BackgroundJobs background;
+
+	//gameplay random numbers, one stream per use, so (e.g.) a change in how spices move doesn't change what spawns:
+	struct RandomStreams {
+		PCG32 spawn; //which food comes next, and where
+		PCG32 spice; //where GarnishLevel's spice shaker goes
+	} random;
+	//the streams are re-seeded from (seed, scene_loads) by every load_scene;
+	// set 'seed' before the first load_scene to reproduce a session (e.g. when replaying input):
+	uint32_t seed = 0;
+	uint32_t scene_loads = 0;
 
 	Portal players[2];
 	float rot_speeds[2] = {0,0};
@@ -51,10 +71,14 @@ struct GameMode : public Mode {
     std::vector <uint32_t> high_scores = {50, 0, 0};
     uint32_t level = 10;
 	Scene::Camera * camera = nullptr;
+	Scene::Lamp * spot = nullptr; //shadow-casting spot light (see draw_shadow_map in GameMode.cpp)
 
 	// Level *current_level = nullptr;
 	std::shared_ptr< Level > current_level = nullptr;
 
+	//cosmetic effects (splashes, steam, ...); levels emit into this, and it's emptied by load_scene:
+	ParticleSystem particles;
+
 	std::list<Scene::Object *> foods;
 	std::vector<Scene::Object *> pots;
 
@@ -63,6 +87,10 @@ struct GameMode : public Mode {
 
 	void save_game();
 
+	//quicksave the level in progress to a save slot, or put it back the way it was saved (see Quicksave.hpp):
+	void save_state(uint32_t slot);
+	void load_state(uint32_t slot);
+
     void show_pause_menu();
     void show_lose();
     void show_win();
@@ -70,7 +98,55 @@ struct GameMode : public Mode {
 
 	bool paused = false;
 
+	//SDL's mouse functions may only be called from the main thread, but GameMode::handle_event can run
+	// on the simulation thread, so it asks for a change here; main.cpp makes it once the simulation has
+	// finished (and resets this to MouseModeUnchanged). (The level select choices set it too, for
+	// consistency -- menus always run on the main thread.)
+	enum MouseMode {
+		MouseModeUnchanged,
+		MouseModeRelative, //hidden cursor, motion only (SDL_SetRelativeMouseMode(SDL_TRUE))
+		MouseModeAbsolute,
+	} wanted_mouse_mode = MouseModeUnchanged;
+
     Scene *scene = nullptr;
+
+	//post-processing settings for the glow (bloom) around portals:
+	struct BloomSettings {
+		uint32_t levels = 5; //number of successively half-sized levels in the bloom chain (more = wider glow)
+		uint32_t divisor = 2; //the first level is 1/divisor of the screen size (larger = cheaper, blockier)
+		bool wide_kernel = true; //9-tap (vs 5-tap) gaussian blur at each level
+		float threshold = 0.0f; //glow below this brightness is dropped
+		float intensity = 0.7f; //amount of bloom added to the final image
+	} bloom;
+
+	//dynamic resolution: the scene is drawn at 'scale' times the window size and stretched to fit,
+	// with 'scale' adjusted from GPU timer results to keep GPU time per frame near 'target_ms'.
+	//(text and meters are drawn afterward, at full resolution -- see Level::render_overlay)
+	//set NO_DYNAMIC_RESOLUTION in the environment to always draw at full size.
+	struct ResolutionSettings {
+		bool dynamic = true;
+		float target_ms = 12.0f; //(leaves some headroom under a 60Hz vsync interval)
+		float min_scale = 0.5f;
+		float max_scale = 1.0f;
+		float scale = 1.0f; //current scale
+		uint32_t settle = 0; //timer results to ignore after a change (they were measured at the old scale)
+	} resolution;
+
+	//copy of everything draw() looks at, made by capture_draw_state() (with transforms blended
+	// between ticks), so the next update can change the scene while this one is being drawn:
+	struct DrawState {
+		Scene scene;
+		Scene::CopyMap copies; //(kept to avoid re-allocating every frame)
+		Scene::Camera *camera = nullptr; //(these point into 'scene')
+		Scene::Lamp *spot = nullptr;
+		Portal portals[2]; //position, normal, transform, and vicinity of 'players'
+		std::shared_ptr< Level > level; //(levels keep their own copies; see Level::capture_draw_state)
+		glm::vec3 sky_color = glm::vec3(0.0f);
+		glm::vec3 sky_direction = glm::vec3(0.0f, 0.0f, 1.0f);
+		uint32_t level_index = 0;
+		uint32_t score = 0;
+		uint32_t high_score = 0;
+	} drawn;
 };
 
 extern Load< MeshBuffer > vegetable_meshes;
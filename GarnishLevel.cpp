@@ -37,13 +37,8 @@ GarnishLevel::GarnishLevel(GameMode *gm,
 
     texture_program_info.vao = *garnish_meshes_for_texture_program;
 
-    texture_program_info.set_uniforms = [](){
-        glUniform1f(texture_program->glow_amt_float, 0.0f);
-        glUniform3fv(texture_program->sky_color_vec3, 1,
-                glm::value_ptr(glm::vec3(1.f,1.f,1.f)));
-        glUniform3fv(texture_program->sky_direction_vec3, 1,
-                glm::value_ptr(glm::vec3(0.f, 1.f, 1.0f)));
-    };
+    sky_color = glm::vec3(1.f,1.f,1.f);
+    sky_direction = glm::vec3(0.f, 1.f, 1.0f);
 
 
 	{ // set up steak and plate
@@ -85,6 +80,8 @@ Scene::Object *GarnishLevel::create_bg(std::string veg_name) {
 	obj->programs[Scene::Object::ProgramTypeShadow] = depth_program_info;
 
 	MeshBuffer::Mesh const &mesh = vegetable_meshes->lookup(veg_name);
+	obj->mesh_min = mesh.min;
+	obj->mesh_max = mesh.max;
 	obj->programs[Scene::Object::ProgramTypeDefault].start = mesh.start;
 	obj->programs[Scene::Object::ProgramTypeDefault].count = mesh.count;
 
@@ -106,6 +103,8 @@ Scene::Object *GarnishLevel::create_food(std::string veg_name) {
 	obj->programs[Scene::Object::ProgramTypeShadow] = depth_program_info;
 
 	MeshBuffer::Mesh const &mesh = garnish_meshes->lookup(veg_name);
+	obj->mesh_min = mesh.min;
+	obj->mesh_max = mesh.max;
 	obj->programs[Scene::Object::ProgramTypeDefault].start = mesh.start;
 	obj->programs[Scene::Object::ProgramTypeDefault].count = mesh.count;
 
@@ -116,12 +115,46 @@ Scene::Object *GarnishLevel::create_food(std::string veg_name) {
 	return obj;
 }
 void GarnishLevel::spawn_food() {
-    Scene::Object *obj = create_food(spice_names[message]);
+    Scene::Object *obj = add_food(spice_names[message]);
+    obj->transform->position = pos + glm::vec3(gm->random.spawn.below(10),0.f,0.f);
+	obj->transform->boundingbox->update_origin(obj->transform->position, glm::vec2(0.0f, 1.0f));
+}
+
+Scene::Object *GarnishLevel::add_food(std::string const &data) {
+    Scene::Object *obj = create_food(data);
     obj->lifespan = 8.0f;
-    obj->transform->position = pos + glm::vec3(gm->random_gen() % 10,0.f,0.f);
 	obj->transform->boundingbox = new BoundingBox(2.0f, 2.0f);
-	obj->transform->boundingbox->update_origin(obj->transform->position, glm::vec2(0.0f, 1.0f));
+	obj->data = data;
+	obj->moves = true;
 	gm->foods.push_back(obj);
+	return obj;
+}
+
+struct GarnishLevelState {
+    uint32_t message;
+    float messagetime;
+    float salt_time;
+    float total_time;
+    float time;
+    float score;
+    glm::vec3 pos;
+};
+
+void GarnishLevel::save_state(std::vector< uint8_t > *out) const {
+    save_pod(out, GarnishLevelState{message, messagetime, salt_time, total_time, time, score, pos});
+}
+
+bool GarnishLevel::restore_state(uint8_t const *data, size_t size) {
+    GarnishLevelState state;
+    if (!restore_pod(data, size, &state)) return false;
+    message = state.message;
+    messagetime = state.messagetime;
+    salt_time = state.salt_time;
+    total_time = state.total_time;
+    time = state.time;
+    score = state.score;
+    pos = state.pos;
+    return true;
 }
 
 void GarnishLevel::update(float elapsed) {
@@ -138,10 +171,10 @@ void GarnishLevel::update(float elapsed) {
         salt_time -= elapsed;
         if(salt_time<=0.f){
             salt_time = 3.f;
-            pos.x = gm->random_gen()%150 - 75.f;
+            pos.x = gm->random.spice.below(150) - 75.f;
         }
     }else{
-        pos.x = gm->random_gen()%150 - 75.f;
+        pos.x = gm->random.spice.below(150) - 75.f;
     }
 
     for(auto iter = gm->foods.begin(); iter != gm->foods.end();) {
@@ -151,6 +184,23 @@ void GarnishLevel::update(float elapsed) {
             &&food_transform->position.x < steak->transform->position.x+10.f) {
                 (*iter)->lifespan = 0.0f;
                 gm->scores[gm->level]+=10;
+
+                { // scatter a few flakes where it landed
+                    glm::vec4 spice_colors[] = {
+                        glm::vec4(0.3f, 0.6f, 0.2f, 1.f),  // chives
+                        glm::vec4(1.f, 1.f, 1.f, 1.f),     // salt
+                        glm::vec4(0.15f, 0.12f, 0.1f, 1.f) // pepper
+                    };
+                    ParticleSystem::Particle flake;
+                    flake.position = glm::vec3(food_transform->position.x, food_transform->position.y, 10.f);
+                    flake.velocity = glm::vec3(0.f, 10.f, 0.f);
+                    flake.gravity = -40.f;
+                    flake.life = 0.5f;
+                    flake.size = 0.35f;
+                    flake.color = spice_colors[message];
+                    gm->particles.emit_burst(12, flake, glm::vec3(1.f, 0.5f, 0.f), glm::vec3(8.f, 5.f, 0.f));
+                }
+
                 if(message==0 && gm->scores[gm->level]==200){
                     message++;
                     messagetime=3.f;
@@ -184,15 +234,15 @@ void GarnishLevel::fall_off(Scene::Object *o) {
 	}
 }
 
-void GarnishLevel::render_pass() {
+void GarnishLevel::render_overlay() {
 
 	glDisable(GL_DEPTH_TEST);
 
-	if (messagetime > 0.f) {
+	if (drawn.messagetime > 0.f) {
         std::string text;
-        if(message==0) text= "TIME FOR SOME CHIVES";
-        if(message==1) text= "TIME FOR SOME SALT";
-        if(message==2) text= "TIME FOR SOME PEPPER";
+        if(drawn.message==0) text= "TIME FOR SOME CHIVES";
+        if(drawn.message==1) text= "TIME FOR SOME SALT";
+        if(drawn.message==2) text= "TIME FOR SOME PEPPER";
 
         float height = 0.1f;
 
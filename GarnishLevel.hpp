@@ -16,7 +16,14 @@ struct GarnishLevel : public Level {
 
 	virtual void update(float elapsed) override;
 	virtual void fall_off(Scene::Object *o) override;
-    virtual void render_pass() override;
+    virtual void render_overlay() override;
+    virtual void capture_draw_state() override {
+        drawn.message = message;
+        drawn.messagetime = messagetime;
+    }
+    virtual void save_state(std::vector< uint8_t > *out) const override;
+    virtual bool restore_state(uint8_t const *data, size_t size) override;
+    virtual Scene::Object *add_food(std::string const &data) override;
 
 
     Scene::Object *create_food(std::string veg_name);
@@ -30,4 +37,9 @@ struct GarnishLevel : public Level {
     float time = 0.f;
     float score = 0.f;
     glm::vec3 pos = glm::vec3(10.0, 50.0f, 0.0f);
+
+    struct {
+        uint32_t message = 0;
+        float messagetime = 0.f;
+    } drawn; //(copied for render_overlay)
 };
@@ -0,0 +1,199 @@
+#include "InputRecord.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <cassert>
+
+//version 2: 'elapsed' is simulated in fixed ticks (see Mode::Tick), so version 1 recordings no longer replay exactly
+//version 3: mouse events carry their time within the frame (they're handed to the mode in the tick they happened in)
+//version 4: GameMode's random numbers come from PCG32 streams (see pcg32.hpp) rather than a std::mt19937
+static constexpr uint32_t RecordingVersion = 4;
+
+//------------ helpers for compact encoding ------------
+
+static void put_varint(std::vector< uint8_t > &out, uint32_t v) {
+	while (v >= 0x80) {
+		out.emplace_back(uint8_t(v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+	out.emplace_back(uint8_t(v));
+}
+
+static void put_signed(std::vector< uint8_t > &out, int32_t v) {
+	put_varint(out, (uint32_t(v) << 1) ^ uint32_t(v >> 31));
+}
+
+static void put_u32(std::vector< uint8_t > &out, uint32_t v) {
+	for (uint32_t i = 0; i < 4; ++i) {
+		out.emplace_back(uint8_t(v >> (8 * i)));
+	}
+}
+
+struct Reader {
+	Reader(std::vector< uint8_t > const &data_, size_t &at_) : data(data_), at(at_) { }
+	std::vector< uint8_t > const &data;
+	size_t &at;
+
+	uint8_t byte() {
+		if (at >= data.size()) throw std::runtime_error("Input recording is truncated.");
+		return data[at++];
+	}
+	uint32_t varint() {
+		uint32_t v = 0;
+		for (uint32_t shift = 0; shift < 35; shift += 7) {
+			uint8_t b = byte();
+			v |= uint32_t(b & 0x7f) << shift;
+			if (!(b & 0x80)) return v;
+		}
+		throw std::runtime_error("Input recording contains an invalid integer.");
+	}
+	int32_t signed_varint() {
+		uint32_t z = varint();
+		return int32_t(z >> 1) ^ -int32_t(z & 1);
+	}
+	uint32_t u32() {
+		uint32_t v = 0;
+		for (uint32_t i = 0; i < 4; ++i) {
+			v |= uint32_t(byte()) << (8 * i);
+		}
+		return v;
+	}
+};
+
+//------------ recording ------------
+
+InputRecorder::InputRecorder(std::string const &filename, uint32_t seed, glm::uvec2 const &window_size) {
+	file.open(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open '" + filename + "' to record input.");
+	}
+	buffer.clear();
+	buffer.insert(buffer.end(), {'i', 'n', 'p', '0'});
+	put_u32(buffer, RecordingVersion);
+	put_u32(buffer, seed);
+	put_u32(buffer, window_size.x);
+	put_u32(buffer, window_size.y);
+	file.write(reinterpret_cast< char const * >(buffer.data()), buffer.size());
+}
+
+InputRecorder::~InputRecorder() {
+	file.flush();
+	std::cout << "Recorded " << frames << " frames of input." << std::endl;
+}
+
+void InputRecorder::write_frame(InputFrame const &frame) {
+	buffer.clear();
+
+	uint32_t elapsed_bits;
+	static_assert(sizeof(elapsed_bits) == sizeof(frame.elapsed), "float is 32 bits");
+	std::memcpy(&elapsed_bits, &frame.elapsed, sizeof(elapsed_bits));
+	put_u32(buffer, elapsed_bits);
+
+	//only the fields the game's modes look at are stored:
+	put_varint(buffer, uint32_t(frame.events.size()));
+	for (auto const &evt : frame.events) {
+		put_varint(buffer, evt.type);
+		if (evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP) {
+			put_varint(buffer, uint32_t(evt.key.keysym.scancode));
+			put_varint(buffer, uint32_t(evt.key.keysym.sym));
+			put_varint(buffer, evt.key.keysym.mod);
+			buffer.emplace_back(evt.key.state);
+			buffer.emplace_back(evt.key.repeat);
+		} else if (evt.type == SDL_WINDOWEVENT) {
+			buffer.emplace_back(evt.window.event);
+			put_signed(buffer, evt.window.data1);
+			put_signed(buffer, evt.window.data2);
+		}
+	}
+
+	assert(frame.mouse_times.size() == frame.mouse_events.size());
+	put_varint(buffer, uint32_t(frame.mouse_events.size()));
+	for (uint32_t i = 0; i < frame.mouse_events.size(); ++i) {
+		ManyMouseEvent const &evt = frame.mouse_events[i];
+		buffer.emplace_back(uint8_t(evt.type));
+		put_varint(buffer, evt.device);
+		put_varint(buffer, evt.item);
+		put_signed(buffer, evt.value);
+		if (evt.type == MANYMOUSE_EVENT_ABSMOTION) {
+			put_signed(buffer, evt.minval);
+			put_signed(buffer, evt.maxval);
+		}
+		uint32_t time_bits;
+		std::memcpy(&time_bits, &frame.mouse_times[i], sizeof(time_bits));
+		put_u32(buffer, time_bits);
+	}
+
+	file.write(reinterpret_cast< char const * >(buffer.data()), buffer.size());
+	frames += 1;
+}
+
+//------------ replay ------------
+
+InputReplay::InputReplay(std::string const &filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open input recording '" + filename + "'.");
+	}
+	data.assign(std::istreambuf_iterator< char >(file), std::istreambuf_iterator< char >());
+
+	Reader read(data, at);
+	char magic[4];
+	for (auto &c : magic) c = char(read.byte());
+	if (std::string(magic, 4) != "inp0") {
+		throw std::runtime_error("File '" + filename + "' is not an input recording.");
+	}
+	uint32_t version = read.u32();
+	if (version != RecordingVersion) {
+		throw std::runtime_error("Input recording '" + filename + "' has version " + std::to_string(version) + "; expected " + std::to_string(RecordingVersion) + ".");
+	}
+	seed = read.u32();
+	window_size.x = read.u32();
+	window_size.y = read.u32();
+}
+
+bool InputReplay::read_frame(InputFrame *frame) {
+	assert(frame);
+	if (at >= data.size()) return false;
+
+	Reader read(data, at);
+
+	uint32_t elapsed_bits = read.u32();
+	std::memcpy(&frame->elapsed, &elapsed_bits, sizeof(elapsed_bits));
+
+	frame->events.resize(read.varint());
+	for (auto &evt : frame->events) {
+		SDL_zero(evt);
+		evt.type = read.varint();
+		if (evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP) {
+			evt.key.keysym.scancode = SDL_Scancode(read.varint());
+			evt.key.keysym.sym = SDL_Keycode(read.varint());
+			evt.key.keysym.mod = uint16_t(read.varint());
+			evt.key.state = read.byte();
+			evt.key.repeat = read.byte();
+		} else if (evt.type == SDL_WINDOWEVENT) {
+			evt.window.event = read.byte();
+			evt.window.data1 = read.signed_varint();
+			evt.window.data2 = read.signed_varint();
+		}
+	}
+
+	frame->mouse_events.resize(read.varint());
+	frame->mouse_times.resize(frame->mouse_events.size());
+	for (uint32_t i = 0; i < frame->mouse_events.size(); ++i) {
+		ManyMouseEvent &evt = frame->mouse_events[i];
+		evt = ManyMouseEvent();
+		evt.type = ManyMouseEventType(read.byte());
+		evt.device = read.varint();
+		evt.item = read.varint();
+		evt.value = read.signed_varint();
+		if (evt.type == MANYMOUSE_EVENT_ABSMOTION) {
+			evt.minval = read.signed_varint();
+			evt.maxval = read.signed_varint();
+		}
+		uint32_t time_bits = read.u32();
+		std::memcpy(&frame->mouse_times[i], &time_bits, sizeof(time_bits));
+	}
+
+	return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "manymouse/manymouse.h"
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+//Input recording and replay.
+// A recording captures, per frame, every SDL event and ManyMouse event delivered to
+// the current Mode along with the frame's real 'elapsed' time (which main.cpp turns into
+// fixed-size Mode::update ticks). Together with the random seed stored in the header,
+// replaying a recording reproduces GameMode::update exactly.
+//
+//File layout:
+// header: "inp0", version (uint32), seed (uint32), window size (2 x uint32)
+// per frame: elapsed (float, raw bits), SDL event count + events, ManyMouse event count + events (each followed by its time)
+// (counts and most event fields are stored as variable-length integers)
+
+//All of the input consumed during one frame:
+struct InputFrame {
+	float elapsed = 0.0f;
+	std::vector< SDL_Event > events;
+	std::vector< ManyMouseEvent > mouse_events;
+	std::vector< float > mouse_times; //when each mouse event happened, in seconds after the start of the frame (0 to elapsed)
+};
+
+struct InputRecorder {
+	//start a new recording (will throw if file can't be opened):
+	InputRecorder(std::string const &filename, uint32_t seed, glm::uvec2 const &window_size);
+	~InputRecorder();
+
+	void write_frame(InputFrame const &frame);
+
+	//internals:
+	std::ofstream file;
+	std::vector< uint8_t > buffer; //bytes for the current frame, written in one go
+	uint32_t frames = 0;
+};
+
+struct InputReplay {
+	//load a recording (will throw on read errors or version mismatch):
+	InputReplay(std::string const &filename);
+
+	//read the next frame; returns false at the end of the recording:
+	bool read_frame(InputFrame *frame);
+
+	uint32_t seed = 0;
+	glm::uvec2 window_size = glm::uvec2(0);
+
+	//internals:
+	std::vector< uint8_t > data;
+	size_t at = 0;
+};
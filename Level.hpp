@@ -5,6 +5,9 @@ class Level;
 #include "GameMode.hpp"
 #include "Sound.hpp"
 
+#include <cstring>
+#include <vector>
+
 class Level {
 public:
 	GameMode *gm;
@@ -13,7 +16,55 @@ public:
 	virtual void update(float elapsed) {}
 	virtual bool collision(Scene::Object *o1, Scene::Object *o2) { return false; }
 	virtual void fall_off(Scene::Object *o) {}
+	//drawn in world space after the scene (at the scene's, possibly reduced, resolution):
 	virtual void render_pass() {}
+	//drawn over the finished frame at full window resolution (text, meters):
+	virtual void render_overlay() {}
+	//copy whatever render_pass/render_overlay use, since they run while the next update does (see GameMode::DrawState):
+	virtual void capture_draw_state() {}
+
+	//quicksaves (see Quicksave.hpp) keep the level's own state -- timers, counters -- with these;
+	// restore_state is called on a freshly constructed level, and returns false if 'data' doesn't fit:
+	virtual void save_state(std::vector< uint8_t > *out) const {}
+	virtual bool restore_state(uint8_t const *data, size_t size) { return size == 0; }
+	//make a food of the kind 'data' names (Scene::Object::data), as spawning one would but without placing it,
+	// and add it to gm->foods; returns nullptr if this level doesn't spawn foods:
+	virtual Scene::Object *add_food(std::string const &data) { return nullptr; }
+	//add_food for each of 'datas' (e.g., restoring a quicksave), appending the foods made to 'made';
+	// levels that make many foods override this to look each kind up once:
+	virtual void add_foods(std::vector< std::string > const &datas, std::vector< Scene::Object * > *made) {
+		for (auto const &data : datas) {
+			Scene::Object *obj = add_food(data);
+			if (!obj) return; //(this level doesn't spawn foods)
+			made->push_back(obj);
+		}
+	}
+
+	//let this level's music die away over 'ramp' seconds (load_scene calls this on the outgoing level,
+	// so its music fades under the next level's instead of cutting off):
+	virtual void fade_out(float ramp) {
+		if (bgm) bgm->stop(ramp);
+		bgm.reset();
+	}
+
+	//hemisphere ("sky") light used while this level is running:
+	glm::vec3 sky_color = glm::vec3(0.8f);
+	glm::vec3 sky_direction = glm::vec3(0.0f, 0.0f, 1.0f); //direction *to* sky
 
     std::shared_ptr< Sound::PlayingSample > bgm;
+
+protected:
+	//helpers for save_state/restore_state of levels whose state is a plain struct (copied with memcpy):
+	template< typename T >
+	static void save_pod(std::vector< uint8_t > *out, T const &value) {
+		size_t at = out->size();
+		out->resize(at + sizeof(T));
+		std::memcpy(out->data() + at, &value, sizeof(T));
+	}
+	template< typename T >
+	static bool restore_pod(uint8_t const *data, size_t size, T *value) {
+		if (size != sizeof(T)) return false;
+		std::memcpy(value, data, sizeof(T));
+		return true;
+	}
 };
\ No newline at end of file
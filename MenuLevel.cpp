@@ -1,10 +1,11 @@
 #include "MenuLevel.hpp"
+#include "data_path.hpp"
 
 using namespace glm;
 
 MenuLevel::MenuLevel(GameMode *_gm, Scene::Object::ProgramInfo const &texture_program_info,
                             Scene::Object::ProgramInfo const &depth_program_info) : 
-                                BasicLevel(_gm, texture_program_info, depth_program_info) {
+                                ScriptedLevel(_gm, texture_program_info, depth_program_info, data_path("vegetables.level")) {
     gm->players[0].move_to(vec2(-12.f, 0.f));
     gm->players[1].move_to(vec2(12.f, 0.f));
     
@@ -18,6 +19,8 @@ MenuLevel::MenuLevel(GameMode *_gm, Scene::Object::ProgramInfo const &texture_pr
 	obj->programs[Scene::Object::ProgramTypeShadow] = depth_program_info;
 
 	MeshBuffer::Mesh const &mesh = vegetable_meshes->lookup("Broccoli");
+	obj->mesh_min = mesh.min;
+	obj->mesh_max = mesh.max;
 	obj->programs[Scene::Object::ProgramTypeDefault].start = mesh.start;
 	obj->programs[Scene::Object::ProgramTypeDefault].count = mesh.count;
 
@@ -28,6 +31,7 @@ MenuLevel::MenuLevel(GameMode *_gm, Scene::Object::ProgramInfo const &texture_pr
 	obj->transform->rotation = glm::angleAxis(glm::radians(-90.f), glm::vec3(1.f,0.f,0.f));
 	obj->transform->boundingbox = new BoundingBox(2.0f, 2.0f);
 	obj->transform->boundingbox->update_origin(obj->transform->position, glm::vec2(0.0f, 1.0f));
+	obj->moves = true;
 	gm->foods.push_back(obj);
 }
 
@@ -1,8 +1,8 @@
 #pragma once
 
-#include "BasicLevel.hpp"
+#include "ScriptedLevel.hpp"
 
-struct MenuLevel : public BasicLevel {
+struct MenuLevel : public ScriptedLevel {
     MenuLevel(GameMode *gm, Scene::Object::ProgramInfo const &texture_program_info,
                         Scene::Object::ProgramInfo const &depth_program_info);
     virtual ~MenuLevel() {};
@@ -2,11 +2,13 @@
 #include "MenuMode.hpp"
 
 #include "Load.hpp"
-#include "compile_program.hpp"
+#include "shader_files.hpp"
 #include "MeshBuffer.hpp"
 #include "data_path.hpp"
+#include "check_fb.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -21,25 +23,12 @@ GLint menu_program_mvp = -1;
 GLint menu_program_color = -1;
 
 Load< GLuint > menu_program(LoadTagInit, [](){
-	GLuint *ret = new GLuint(compile_program(
-		"#version 330\n"
-		"uniform mat4 mvp;\n"
-		"in vec4 Position;\n"
-		"void main() {\n"
-		"	gl_Position = mvp * Position;\n"
-		"}\n"
-	,
-		"#version 330\n"
-		"uniform vec3 color;\n"
-		"out vec4 fragColor;\n"
-		"void main() {\n"
-		"	fragColor = vec4(color, 1.0);\n"
-		"}\n"
-	));
-
-	menu_program_mvp = glGetUniformLocation(*ret, "mvp");
-	menu_program_color = glGetUniformLocation(*ret, "color");
-
+	GLuint *ret = new GLuint(0);
+	//sources: dist/shaders/menu.vert, menu.frag
+	load_program_files(ret, "menu.vert", "menu.frag", [](GLuint program){
+		menu_program_mvp = glGetUniformLocation(program, "mvp");
+		menu_program_color = glGetUniformLocation(program, "color");
+	});
 	return ret;
 });
 
@@ -51,30 +40,95 @@ Load< GLuint > menu_binding(LoadTagDefault, [](){
 GLint fade_program_color = -1;
 
 Load< GLuint > fade_program(LoadTagInit, [](){
-	GLuint *ret = new GLuint(compile_program(
-		"#version 330\n"
-		"void main() {\n"
-		"	gl_Position = vec4(4 * (gl_VertexID & 1) - 1,  2 * (gl_VertexID & 2) - 1, 0.0, 1.0);\n"
-		"}\n"
-	,
-		"#version 330\n"
-		"uniform vec4 color;\n"
-		"out vec4 fragColor;\n"
-		"void main() {\n"
-		"	fragColor = color;\n"
-		"}\n"
-	));
-
-	fade_program_color = glGetUniformLocation(*ret, "color");
+	GLuint *ret = new GLuint(0);
+	//sources: dist/shaders/fullscreen.vert, fade.frag
+	load_program_files(ret, "fullscreen.vert", "fade.frag", [](GLuint program){
+		fade_program_color = glGetUniformLocation(program, "color");
+	});
+	return ret;
+});
+
+//The menu backdrop is the background mode's frame, drawn once, shrunk to 1/BackdropDivisor size,
+// blurred (bloom_blur.frag, horizontal then vertical, BackdropBlurPasses times), and faded;
+// each menu frame then only stretches it over the screen (backdrop.frag).
+//(only one menu is shown at a time, so they all share these)
+static constexpr uint32_t BackdropDivisor = 4;
+static constexpr uint32_t BackdropBlurPasses = 2;
+
+//Uniform locations in backdrop_blur_program:
+GLint backdrop_blur_program_dst_size_vec2 = -1;
+GLint backdrop_blur_program_direction_vec2 = -1;
+GLint backdrop_blur_program_wide_bool = -1;
+
+Load< GLuint > backdrop_blur_program(LoadTagInit, [](){
+	GLuint *ret = new GLuint(0);
+	//sources: dist/shaders/fullscreen.vert, bloom_blur.frag (the same blur GameMode's bloom uses)
+	load_program_files(ret, "fullscreen.vert", "bloom_blur.frag", [](GLuint program){
+		backdrop_blur_program_dst_size_vec2 = glGetUniformLocation(program, "dst_size");
+		backdrop_blur_program_direction_vec2 = glGetUniformLocation(program, "direction");
+		backdrop_blur_program_wide_bool = glGetUniformLocation(program, "wide");
+
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "src_tex"), 0);
+		glUseProgram(0);
+	});
+	return ret;
+});
+
+GLint backdrop_program_dst_size_vec2 = -1;
+
+Load< GLuint > backdrop_program(LoadTagInit, [](){
+	GLuint *ret = new GLuint(0);
+	//sources: dist/shaders/fullscreen.vert, backdrop.frag
+	load_program_files(ret, "fullscreen.vert", "backdrop.frag", [](GLuint program){
+		backdrop_program_dst_size_vec2 = glGetUniformLocation(program, "dst_size");
 
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "backdrop_tex"), 0);
+		glUseProgram(0);
+	});
 	return ret;
 });
 
+extern Load< GLuint > empty_vao; //(from GameMode.cpp)
+
+//the backdrop texture, and a same-sized scratch target for the separable blur:
+struct Backdrop {
+	glm::uvec2 size = glm::uvec2(0,0);
+	GLuint tex[2] = {0, 0};
+	GLuint fb[2] = {0, 0};
+
+	void allocate(glm::uvec2 const &new_size) {
+		if (size == new_size) return;
+		size = new_size;
+		for (uint32_t i = 0; i < 2; ++i) {
+			if (tex[i] == 0) glGenTextures(1, &tex[i]);
+			glBindTexture(GL_TEXTURE_2D, tex[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, size.x, size.y, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+			//(linear filtering because the blur relies on bilinear taps, and the backdrop is stretched to the screen)
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			if (fb[i] == 0) glGenFramebuffers(1, &fb[i]);
+			glBindFramebuffer(GL_FRAMEBUFFER, fb[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex[i], 0);
+			check_fb();
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+	}
+} backdrop;
 
 //----------------------
 
 bool MenuMode::handle_event(SDL_Event const &e, glm::uvec2 const &window_size) {
+	if (e.type == SDL_WINDOWEVENT) {
+		redraw = true; //(e.g., uncovered, or moved to another display)
+	}
 	if (e.type == SDL_KEYDOWN) {
+		redraw = true;
 		if (e.key.keysym.sym == SDLK_ESCAPE) {
 			Mode::set_current(nullptr);
 			return true;
@@ -84,6 +138,7 @@ bool MenuMode::handle_event(SDL_Event const &e, glm::uvec2 const &window_size) {
 			selected -= 1;
 			while (selected < choices.size() && !choices[selected].on_select) --selected;
 			if (selected >= choices.size()) selected = old;
+			if (selected != old) bounce = 0.0f;
 
 			return true;
 		} else if (e.key.keysym.sym == SDLK_DOWN) {
@@ -92,6 +147,7 @@ bool MenuMode::handle_event(SDL_Event const &e, glm::uvec2 const &window_size) {
 			selected += 1;
 			while (selected < choices.size() && !choices[selected].on_select) ++selected;
 			if (selected >= choices.size()) selected = old;
+			if (selected != old) bounce = 0.0f;
 
 			return true;
 		} else if (e.key.keysym.sym == SDLK_RETURN || e.key.keysym.sym == SDLK_SPACE) {
@@ -105,29 +161,83 @@ bool MenuMode::handle_event(SDL_Event const &e, glm::uvec2 const &window_size) {
 }
 
 void MenuMode::update(float elapsed) {
-	bounce += elapsed / 0.7f;
-	bounce -= std::floor(bounce);
+	//(the background isn't updated: the backdrop is a still of it)
+	bounce = std::min(Bounces, bounce + elapsed / 0.7f);
+}
 
-	if (background) {
-		background->update(elapsed * background_time_scale);
-	}
+bool MenuMode::needs_draw(glm::uvec2 const &drawable_size) const {
+	return redraw || bounce < Bounces || drawable_size != drawn_size;
 }
 
 void MenuMode::draw(glm::uvec2 const &drawable_size) {
 	if (background && background_fade < 1.0f) {
-		background->draw(drawable_size);
-
 		glDisable(GL_DEPTH_TEST);
-		if (background_fade > 0.0f) {
-			glEnable(GL_BLEND);
-			glBlendEquation(GL_FUNC_ADD);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-			glUseProgram(*fade_program);
-			glUniform4fv(fade_program_color, 1, glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, background_fade)));
-			glDrawArrays(GL_TRIANGLES, 0, 3);
-			glUseProgram(0);
-			glDisable(GL_BLEND);
+		glBindVertexArray(*empty_vao);
+
+		//(re)make the backdrop if it is from another menu or size:
+		static MenuMode const *backdrop_for = nullptr;
+		if (backdrop_captured && (backdrop_for != this || drawable_size != drawn_size)) {
+			//the background's copy was already drawn from, and drawing can change it (GameMode::draw moves the
+			// copies of foods through the portals), so have capture_draw_state copy it again and remake the
+			// backdrop next frame; until then, the old one is stretched to fit:
+			backdrop_captured = false;
+			redraw = true;
+		} else if (!backdrop_captured) {
+			background->draw(drawable_size);
+			backdrop_captured = true;
+			backdrop_for = this;
+
+			glDisable(GL_DEPTH_TEST);
+			glDisable(GL_SCISSOR_TEST);
+			glm::uvec2 size = glm::max(drawable_size / BackdropDivisor, glm::uvec2(1));
+			backdrop.allocate(size);
+
+			//shrink the screen into the backdrop:
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, backdrop.fb[0]);
+			glBlitFramebuffer(0, 0, drawable_size.x, drawable_size.y, 0, 0, size.x, size.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+			//blur (horizontal into scratch, vertical back):
+			glViewport(0, 0, size.x, size.y);
+			glUseProgram(*backdrop_blur_program);
+			glUniform1i(backdrop_blur_program_wide_bool, 1);
+			glUniform2f(backdrop_blur_program_dst_size_vec2, float(size.x), float(size.y));
+			glActiveTexture(GL_TEXTURE0);
+			for (uint32_t pass = 0; pass < BackdropBlurPasses; ++pass) {
+				glBindFramebuffer(GL_FRAMEBUFFER, backdrop.fb[1]);
+				glBindTexture(GL_TEXTURE_2D, backdrop.tex[0]);
+				glUniform2f(backdrop_blur_program_direction_vec2, 1.0f, 0.0f);
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+
+				glBindFramebuffer(GL_FRAMEBUFFER, backdrop.fb[0]);
+				glBindTexture(GL_TEXTURE_2D, backdrop.tex[1]);
+				glUniform2f(backdrop_blur_program_direction_vec2, 0.0f, 1.0f);
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+			}
+
+			//fade:
+			if (background_fade > 0.0f) {
+				glEnable(GL_BLEND);
+				glBlendEquation(GL_FUNC_ADD);
+				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				glUseProgram(*fade_program);
+				glUniform4fv(fade_program_color, 1, glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, background_fade)));
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+				glDisable(GL_BLEND);
+			}
+
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glViewport(0, 0, drawable_size.x, drawable_size.y);
 		}
+
+		//stretch the backdrop over the screen:
+		glUseProgram(*backdrop_program);
+		glUniform2f(backdrop_program_dst_size_vec2, float(drawable_size.x), float(drawable_size.y));
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, backdrop.tex[0]);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glUseProgram(0);
 	}
 	glDisable(GL_DEPTH_TEST);
 
@@ -161,7 +271,7 @@ void MenuMode::draw(glm::uvec2 const &drawable_size) {
 		return 1.0f;
 	};
 
-	float select_bounce = std::abs(std::sin(bounce * 3.1515926f * 2.0f));
+	float select_bounce = (bounce < Bounces ? std::abs(std::sin(bounce * 3.1415926f * 2.0f)) : 0.0f);
 
 	float y = 0.5f * total_height;
 	for (auto const &choice : choices) {
@@ -213,4 +323,7 @@ void MenuMode::draw(glm::uvec2 const &drawable_size) {
 	}
 
 	glEnable(GL_DEPTH_TEST);
+
+	redraw = false;
+	drawn_size = drawable_size;
 }
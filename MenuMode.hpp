@@ -12,6 +12,9 @@ struct MenuMode : public Mode {
 	virtual bool handle_event(SDL_Event const &event, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
 	virtual void draw(glm::uvec2 const &drawable_size) override;
+	//(menus are cheap to update, so they run in step with drawing; the background needs its copy made once, for the backdrop)
+	virtual void capture_draw_state() override { if (background && !backdrop_captured) background->capture_draw_state(); }
+	virtual bool needs_draw(glm::uvec2 const &drawable_size) const override;
 
 	struct Choice {
 		Choice(std::string const &label_, std::function< void() > on_select_ = nullptr) : label(label_), on_select(on_select_) { }
@@ -23,14 +26,22 @@ struct MenuMode : public Mode {
 	};
 	std::vector< Choice > choices;
 	uint32_t selected = 0;
-	float bounce = 0.0f;
+	//the selected choice bounces a few times after it is picked, then rests (so an idle menu doesn't need drawing):
+	static constexpr float Bounces = 3.0f;
+	float bounce = 0.0f; //bounces so far
 
 	//called when user presses 'escape':
 	// (note: if not defined, menumode will Mode::set_current(background).)
 	std::function< void() > on_escape;
 
 	//will render this mode in the background if not null:
+	// (it is drawn once -- frozen -- then blurred and faded into a small "backdrop" texture that is
+	//  stretched over the screen each frame; it's drawn again only if the window changes size)
 	std::shared_ptr< Mode > background;
-	float background_time_scale = 1.0f;
 	float background_fade = 0.5f;
+
+	//internals:
+	bool backdrop_captured = false; //the backdrop was made from background's latest copy of its draw state (so don't copy again)
+	bool redraw = true; //something changed since the last draw
+	glm::uvec2 drawn_size = glm::uvec2(0); //drawable size at the last draw
 };
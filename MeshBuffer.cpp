@@ -17,6 +17,7 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 	std::ifstream file(filename, std::ios::binary);
 
 	GLuint total = 0;
+	std::vector< glm::vec3 > positions; //kept to compute per-mesh bounds
 	//read + upload data chunk:
 	if (filename.size() >= 2 && filename.substr(filename.size()-2) == ".p") {
 		struct Vertex {
@@ -33,6 +34,8 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 		total = GLuint(data.size()); //store total for later checks on index
+		positions.reserve(data.size());
+		for (auto const &v : data) positions.emplace_back(v.Position);
 
 		//store attrib locations:
 		Position = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Position));
@@ -53,6 +56,8 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 		total = GLuint(data.size()); //store total for later checks on index
+		positions.reserve(data.size());
+		for (auto const &v : data) positions.emplace_back(v.Position);
 
 		//store attrib locations:
 		Position = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Position));
@@ -75,6 +80,8 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 		total = GLuint(data.size()); //store total for later checks on index
+		positions.reserve(data.size());
+		for (auto const &v : data) positions.emplace_back(v.Position);
 
 		//store attrib locations:
 		Position = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Position));
@@ -99,6 +106,8 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 		total = GLuint(data.size()); //store total for later checks on index
+		positions.reserve(data.size());
+		for (auto const &v : data) positions.emplace_back(v.Position);
 
 		//store attrib locations:
 		Position = Attrib(3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, Position));
@@ -134,6 +143,13 @@ MeshBuffer::MeshBuffer(std::string const &filename) {
 			Mesh mesh;
 			mesh.start = entry.vertex_begin;
 			mesh.count = entry.vertex_end - entry.vertex_begin;
+			if (mesh.count) {
+				mesh.min = mesh.max = positions[entry.vertex_begin];
+				for (uint32_t i = entry.vertex_begin; i < entry.vertex_end; ++i) {
+					mesh.min = glm::min(mesh.min, positions[i]);
+					mesh.max = glm::max(mesh.max, positions[i]);
+				}
+			}
 			bool inserted = meshes.insert(std::make_pair(name, mesh)).second;
 			if (!inserted) {
 				std::cerr << "WARNING: mesh name '" + name + "' in filename '" + filename + "' collides with existing mesh." << std::endl;
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "GL.hpp"
+
+#include <glm/glm.hpp>
+
 #include <map>
 
 //"MeshBuffer" holds a collection of meshes loaded from a file
@@ -38,6 +41,8 @@ struct MeshBuffer {
 	struct Mesh {
 		GLuint start = 0;
 		GLuint count = 0;
+		glm::vec3 min = glm::vec3(0.0f); //object-space bounding box of the mesh's vertices
+		glm::vec3 max = glm::vec3(0.0f);
 	};
 	const Mesh &lookup(std::string const &name) const;
 	
@@ -1,6 +1,8 @@
 #include "Mode.hpp"
 
 std::shared_ptr< Mode > Mode::current;
+constexpr float Mode::Tick;
+float Mode::tick_alpha = 0.0f;
 
 void Mode::set_current(std::shared_ptr< Mode > const &new_current) {
 	current = new_current;
@@ -18,12 +18,25 @@ public:
 
 	virtual bool handle_mouse_event(ManyMouseEvent const &, glm::uvec2 const &window_size) { return false; }
 
-	//update is called at the start of a new frame, after events are handled:
-	// 'elapsed' is time in seconds since the last call to 'update'
+	//update is called after events are handled, to advance the simulation by 'elapsed' seconds:
+	// main.cpp always passes 'Tick', calling update as many times per frame as real time requires (possibly none)
 	virtual void update(float elapsed) { }
+	static constexpr float Tick = 1.0f / 120.0f;
 
 	//draw is called after update:
+	// real time is 'tick_alpha' (in [0,1)) of a Tick past the last update; use it to blend between ticks when drawing
 	virtual void draw(glm::uvec2 const &drawable_size) = 0;
+	static float tick_alpha;
+
+	//modes that draw only from a copy of their state, made by capture_draw_state, return true here;
+	// main.cpp then runs their next update (on another thread) while the copy is drawn:
+	virtual bool draws_from_capture() const { return false; }
+	//copy whatever draw needs (called between update and draw, while nothing else runs):
+	virtual void capture_draw_state() { }
+
+	//modes whose picture only changes now and then return false here while the last frame drawn is still right;
+	// main.cpp then leaves that frame on screen and waits for input instead of drawing:
+	virtual bool needs_draw(glm::uvec2 const &drawable_size) const { return true; }
 
 	//Mode::current is the Mode to which events are dispatched.
 	// use 'set_current' to change the current Mode (e.g., to switch to a menu)
@@ -0,0 +1,259 @@
+#include "MouseInput.hpp"
+
+#include <chrono>
+#include <iostream>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+double MouseInput::now() {
+	return std::chrono::duration< double >(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef __linux__
+
+static bool test_bit(std::vector< uint8_t > const &bits, uint32_t bit) {
+	return (bits[bit / 8] >> (bit % 8)) & 1;
+}
+
+//open 'path' if it is an evdev mouse (same tests as ManyMouse's linux_evdev.c):
+static bool open_if_mouse(std::string const &path, MouseInput::Device *device, std::string *name) {
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0 || !S_ISCHR(info.st_mode)) return false;
+	//evdev nodes are major 13, minor 64-96:
+	uint32_t major = (info.st_rdev & 0xff00) >> 8;
+	uint32_t minor = (info.st_rdev & 0x00ff);
+	if (major != 13 || minor < 64 || minor > 96) return false;
+
+	int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0) return false;
+
+	std::vector< uint8_t > keys(KEY_MAX / 8 + 1, 0);
+	std::vector< uint8_t > rels(REL_MAX / 8 + 1, 0);
+	std::vector< uint8_t > abss(ABS_MAX / 8 + 1, 0);
+	bool is_mouse = false;
+	bool absolute = false;
+	if (ioctl(fd, EVIOCGBIT(EV_KEY, keys.size()), keys.data()) != -1) {
+		if (ioctl(fd, EVIOCGBIT(EV_REL, rels.size()), rels.data()) != -1
+		 && test_bit(rels, REL_X) && test_bit(rels, REL_Y) && test_bit(keys, BTN_MOUSE)) {
+			is_mouse = true;
+		}
+		if (ioctl(fd, EVIOCGBIT(EV_ABS, abss.size()), abss.data()) != -1
+		 && test_bit(abss, ABS_X) && test_bit(abss, ABS_Y) && test_bit(keys, BTN_TOUCH)) {
+			is_mouse = true; //touchpad, touchscreen, or tablet
+			absolute = true;
+		}
+	}
+	if (is_mouse && absolute) {
+		struct input_absinfo x, y;
+		if (ioctl(fd, EVIOCGABS(ABS_X), &x) == -1 || ioctl(fd, EVIOCGABS(ABS_Y), &y) == -1) {
+			is_mouse = false;
+		} else {
+			device->min_x = x.minimum;
+			device->max_x = x.maximum;
+			device->min_y = y.minimum;
+			device->max_y = y.maximum;
+		}
+	}
+	if (!is_mouse) {
+		close(fd);
+		return false;
+	}
+
+	char buffer[64] = "Unknown device";
+	ioctl(fd, EVIOCGNAME(sizeof(buffer) - 1), buffer);
+	*name = buffer;
+
+	//have the kernel stamp events with CLOCK_MONOTONIC (rather than wall-clock) time:
+	int clock = CLOCK_MONOTONIC;
+	device->kernel_time = (ioctl(fd, EVIOCSCLOCKID, &clock) == 0);
+	device->fd = fd;
+	return true;
+}
+
+//convert an evdev event to a ManyMouse event (as linux_evdev.c does); returns false for events ManyMouse skips:
+static bool translate(input_event const &in, MouseInput::Device const &device, ManyMouseEvent *out) {
+	*out = ManyMouseEvent();
+	out->value = in.value;
+	if (in.type == EV_REL) {
+		out->type = MANYMOUSE_EVENT_RELMOTION;
+		if (in.code == REL_X || in.code == REL_DIAL) out->item = 0;
+		else if (in.code == REL_Y) out->item = 1;
+		else if (in.code == REL_WHEEL) { out->type = MANYMOUSE_EVENT_SCROLL; out->item = 0; }
+		else if (in.code == REL_HWHEEL) { out->type = MANYMOUSE_EVENT_SCROLL; out->item = 1; }
+		else return false;
+	} else if (in.type == EV_ABS) {
+		out->type = MANYMOUSE_EVENT_ABSMOTION;
+		if (in.code == ABS_X) { out->item = 0; out->minval = device.min_x; out->maxval = device.max_x; }
+		else if (in.code == ABS_Y) { out->item = 1; out->minval = device.min_y; out->maxval = device.max_y; }
+		else return false;
+	} else if (in.type == EV_KEY) {
+		out->type = MANYMOUSE_EVENT_BUTTON;
+		if (in.code >= BTN_LEFT && in.code <= BTN_BACK) out->item = in.code - BTN_MOUSE;
+		else if (in.code >= BTN_MISC && in.code <= BTN_LEFT) out->item = in.code - BTN_MISC;
+		else if (in.code == BTN_TOUCH) out->item = 0;
+		else if (in.code == BTN_STYLUS) out->item = 1;
+		else if (in.code == BTN_STYLUS2) out->item = 2;
+		else return false;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+void MouseInput::reader_main() {
+	std::vector< pollfd > fds;
+	fds.push_back(pollfd{wake_pipe[0], POLLIN, 0});
+	for (auto const &device : devices) {
+		fds.push_back(pollfd{device.fd, POLLIN, 0});
+	}
+
+	auto push = [this](TimedEvent const &timed) {
+		if (!queue.push(timed)) dropped.fetch_add(1, std::memory_order_relaxed);
+	};
+
+	input_event events[64];
+	while (true) {
+		if (::poll(fds.data(), fds.size(), -1) < 0) {
+			if (errno == EINTR) continue;
+			std::cerr << "Mouse input thread stopping: poll failed (" << std::strerror(errno) << ")." << std::endl;
+			break;
+		}
+		if (fds[0].revents) break; //asked to stop
+
+		for (uint32_t i = 1; i < fds.size(); ++i) {
+			if (fds[i].fd < 0 || fds[i].revents == 0) continue;
+			Device const &device = devices[i - 1];
+			while (true) {
+				ssize_t got = read(fds[i].fd, events, sizeof(events));
+				if (got < 0 && errno == EINTR) continue;
+				if (got < 0 && errno == EAGAIN) break;
+				if (got <= 0) {
+					//unplugged (or otherwise unreadable); stop reading it:
+					TimedEvent timed;
+					timed.event.type = MANYMOUSE_EVENT_DISCONNECT;
+					timed.event.device = i - 1;
+					timed.time = now();
+					push(timed);
+					fds[i].fd = -1; //(poll ignores negative fds; the destructor still closes it)
+					break;
+				}
+				double read_time = now();
+				for (uint32_t e = 0; e < uint32_t(got) / sizeof(input_event); ++e) {
+					TimedEvent timed;
+					if (!translate(events[e], device, &timed.event)) continue;
+					timed.event.device = i - 1;
+					timed.time = (device.kernel_time
+						? double(events[e].input_event_sec) + 1e-6 * double(events[e].input_event_usec) + monotonic_offset
+						: read_time);
+					push(timed);
+				}
+			}
+		}
+	}
+}
+
+#endif //__linux__
+
+MouseInput::MouseInput() {
+#ifdef __linux__
+	if (DIR *dir = opendir("/dev/input")) {
+		//(readdir order, as in ManyMouse, so device numbers are the same either way)
+		while (dirent *entry = readdir(dir)) {
+			Device device;
+			std::string name;
+			if (open_if_mouse(std::string("/dev/input/") + entry->d_name, &device, &name)) {
+				devices.emplace_back(device);
+				device_names.emplace_back(name);
+			}
+		}
+		closedir(dir);
+	}
+	if (!devices.empty() && pipe(wake_pipe) == 0) {
+		timespec mono;
+		clock_gettime(CLOCK_MONOTONIC, &mono);
+		monotonic_offset = now() - (double(mono.tv_sec) + 1e-9 * double(mono.tv_nsec));
+
+		driver_name = "Linux /dev/input/event* interface (input thread)";
+		threaded = true;
+		reader = std::thread(&MouseInput::reader_main, this);
+	} else {
+		for (auto &device : devices) {
+			close(device.fd);
+		}
+		devices.clear();
+		device_names.clear();
+	}
+#endif
+
+	if (!threaded) {
+		int count = ManyMouse_Init();
+		if (count < 0) {
+			std::cerr << "Error initializing ManyMouse!" << std::endl;
+		}
+		char const *name = ManyMouse_DriverName();
+		driver_name = (name ? name : "none");
+		for (int i = 0; i < count; ++i) {
+			char const *device = ManyMouse_DeviceName(i);
+			device_names.emplace_back(device ? device : "Unknown device");
+		}
+	}
+
+	std::cout << "ManyMouse driver: " << driver_name << std::endl;
+	if (device_names.empty()) {
+		std::cout << "No mice detected!" << std::endl;
+	}
+	for (uint32_t i = 0; i < device_names.size(); ++i) {
+		std::cout << "#" << i << ": " << device_names[i] << std::endl;
+	}
+}
+
+MouseInput::~MouseInput() {
+#ifdef __linux__
+	if (threaded) {
+		char stop = 1;
+		while (write(wake_pipe[1], &stop, 1) < 0 && errno == EINTR) { }
+		reader.join();
+		for (auto &device : devices) {
+			close(device.fd);
+		}
+		close(wake_pipe[0]);
+		close(wake_pipe[1]);
+		return;
+	}
+#endif
+	ManyMouse_Quit();
+}
+
+void MouseInput::poll(std::vector< ManyMouseEvent > *events, std::vector< double > *times) {
+#ifdef __linux__
+	if (threaded) {
+		TimedEvent timed;
+		while (queue.pop(&timed)) {
+			events->emplace_back(timed.event);
+			times->emplace_back(timed.time);
+		}
+		uint32_t lost = dropped.exchange(0, std::memory_order_relaxed);
+		if (lost) {
+			std::cerr << "Note: mouse input queue overflowed; dropped " << lost << " events." << std::endl;
+		}
+		return;
+	}
+#endif
+	double time = now();
+	ManyMouseEvent event;
+	while (ManyMouse_PollEvent(&event) != 0) {
+		events->emplace_back(event);
+		times->emplace_back(time);
+	}
+}
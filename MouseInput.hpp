@@ -0,0 +1,52 @@
+#pragma once
+
+#include "manymouse/manymouse.h"
+#include "spsc_queue.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+//MouseInput delivers ManyMouse events along with when they happened.
+//On Linux, a thread waits on the /dev/input/event* mice with poll() and queues each event with the
+// kernel's timestamp for it, so timing doesn't depend on how often frames come around.
+// (devices are found the same way, in the same order, as ManyMouse's evdev driver, so device numbers match)
+//Elsewhere -- or if no evdev mouse can be opened -- ManyMouse itself is polled once per frame,
+// and events are stamped with the time they were polled.
+struct MouseInput {
+	MouseInput();
+	~MouseInput();
+
+	//append events that arrived since the last call, along with when they happened
+	// (seconds on std::chrono::steady_clock's clock):
+	void poll(std::vector< ManyMouseEvent > *events, std::vector< double > *times);
+
+	std::string driver_name;
+	std::vector< std::string > device_names;
+
+	//seconds on std::chrono::steady_clock's clock:
+	static double now();
+
+	//internals:
+	struct TimedEvent {
+		ManyMouseEvent event;
+		double time = 0.0;
+	};
+	bool threaded = false; //reading evdev devices on 'reader'?
+#ifdef __linux__
+	struct Device {
+		int fd = -1;
+		int min_x = 0, min_y = 0, max_x = 0, max_y = 0; //(for absolute devices)
+		bool kernel_time = false; //are event timestamps on CLOCK_MONOTONIC?
+	};
+	std::vector< Device > devices;
+	int wake_pipe[2] = {-1, -1}; //written to stop the reader
+	double monotonic_offset = 0.0; //steady_clock time minus CLOCK_MONOTONIC time
+
+	std::thread reader;
+	void reader_main();
+	SPSCQueue< TimedEvent, 1024 > queue;
+	std::atomic< uint32_t > dropped{0}; //events lost because the queue was full
+#endif
+};
@@ -0,0 +1,220 @@
+#include "ParticleSystem.hpp"
+
+#include "Load.hpp"
+#include "shader_files.hpp"
+#include "gl_errors.hpp"
+
+#include <SDL.h>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+
+//------------ resources ------------
+
+//Uniform locations in particle_update_program:
+GLint particle_update_program_elapsed_float = -1;
+
+Load< GLuint > particle_update_program(LoadTagInit, [](){
+	GLuint *ret = new GLuint(0);
+	//sources: dist/shaders/particle_update.vert, particle_update.frag
+	//(outputs are captured, in Particle order, by transform feedback)
+	load_program_files(ret, "particle_update.vert", "particle_update.frag", [](GLuint program){
+		particle_update_program_elapsed_float = glGetUniformLocation(program, "elapsed");
+	}, {"position_life", "velocity_gravity", "color", "size_growth_drag_lifespan"});
+	return ret;
+});
+
+//Uniform locations in particle_program:
+GLint particle_program_world_to_clip_mat4 = -1;
+GLint particle_program_right_vec3 = -1;
+GLint particle_program_up_vec3 = -1;
+
+Load< GLuint > particle_program(LoadTagInit, [](){
+	GLuint *ret = new GLuint(0);
+	//sources: dist/shaders/particle.vert, particle.frag
+	load_program_files(ret, "particle.vert", "particle.frag", [](GLuint program){
+		particle_program_world_to_clip_mat4 = glGetUniformLocation(program, "world_to_clip");
+		particle_program_right_vec3 = glGetUniformLocation(program, "right");
+		particle_program_up_vec3 = glGetUniformLocation(program, "up");
+	});
+	return ret;
+});
+
+//----------------------
+
+ParticleSystem::ParticleSystem() {
+	//(glVertexAttribDivisor is GL 3.3, newer than gl_shims covers, so it is looked up at runtime)
+	PFNGLVERTEXATTRIBDIVISORPROC VertexAttribDivisor = reinterpret_cast< PFNGLVERTEXATTRIBDIVISORPROC >(SDL_GL_GetProcAddress("glVertexAttribDivisor"));
+	if (!VertexAttribDivisor) {
+		throw std::runtime_error("ParticleSystem needs glVertexAttribDivisor (OpenGL 3.3).");
+	}
+
+	glGenBuffers(2, buffers);
+	zero_buffers();
+
+	//attribute locations are fixed in particle_update.vert and particle.vert:
+	auto make_vao = [&VertexAttribDivisor](GLuint buffer, GLuint divisor) {
+		GLuint vao = 0;
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (GLbyte *)0 + offsetof(Particle, position));
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (GLbyte *)0 + offsetof(Particle, velocity));
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (GLbyte *)0 + offsetof(Particle, color));
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (GLbyte *)0 + offsetof(Particle, size));
+		for (GLuint i = 0; i < 4; ++i) {
+			glEnableVertexAttribArray(i);
+			VertexAttribDivisor(i, divisor);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+		return vao;
+	};
+	for (uint32_t i = 0; i < 2; ++i) {
+		update_vaos[i] = make_vao(buffers[i], 0);
+		draw_vaos[i] = make_vao(buffers[i], 1);
+	}
+	GL_ERRORS();
+
+	std::random_device r;
+	random.seed((uint64_t(r()) << 32) | r());
+}
+
+ParticleSystem::~ParticleSystem() {
+	glDeleteVertexArrays(2, draw_vaos);
+	glDeleteVertexArrays(2, update_vaos);
+	glDeleteBuffers(2, buffers);
+}
+
+void ParticleSystem::emit(Particle const &particle) {
+	if (particle.life <= 0.0f) return;
+	if (pending.size() >= 2 * Capacity) {
+		//(nothing has been drawn in a while -- e.g., when running headless -- so drop the oldest, which would be overwritten anyway)
+		pending.erase(pending.begin(), pending.begin() + Capacity);
+	}
+	pending.emplace_back(particle);
+	if (pending.back().lifespan <= 0.0f) pending.back().lifespan = particle.life;
+	quiet = 0.0f;
+	longest_life = std::max(longest_life, particle.life);
+}
+
+void ParticleSystem::emit_burst(uint32_t count, Particle const &base, glm::vec3 const &position_jitter, glm::vec3 const &velocity_jitter) {
+	auto unit = [this]() { return random.uniform(-1.0f, 1.0f); };
+	for (uint32_t i = 0; i < count; ++i) {
+		Particle particle = base;
+		glm::vec3 a(unit(), unit(), unit());
+		glm::vec3 b(unit(), unit(), unit());
+		particle.position += a * position_jitter;
+		particle.velocity += b * velocity_jitter;
+		particle.life *= 1.0f + 0.25f * unit();
+		particle.lifespan = particle.life;
+		emit(particle);
+	}
+}
+
+void ParticleSystem::clear() {
+	pending.clear();
+	clear_pending = true;
+	step_elapsed = 0.0f;
+	quiet = 0.0f;
+	longest_life = 0.0f;
+}
+
+void ParticleSystem::update(float elapsed) {
+	step_elapsed += elapsed;
+	quiet += elapsed;
+}
+
+void ParticleSystem::capture_draw_state() {
+	if (clear_pending) {
+		upload.clear();
+		upload_clear = true;
+		upload_elapsed = 0.0f;
+		clear_pending = false;
+	}
+	upload.insert(upload.end(), pending.begin(), pending.end());
+	pending.clear();
+	if (upload.size() > Capacity) {
+		//(only the newest 'Capacity' would survive the upload anyway)
+		upload.erase(upload.begin(), upload.end() - Capacity);
+	}
+	upload_elapsed += step_elapsed;
+	step_elapsed = 0.0f;
+	alive = !(quiet > longest_life);
+}
+
+void ParticleSystem::zero_buffers() {
+	next_slot = 0;
+	used_slots = 0;
+
+	//(all-zero particles have zero life, so are dead)
+	std::vector< char > zeros(Capacity * sizeof(Particle), 0);
+	for (GLuint buffer : buffers) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, zeros.size(), zeros.data(), GL_DYNAMIC_COPY);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GL_ERRORS();
+}
+
+void ParticleSystem::draw(glm::mat4 const &world_to_clip, glm::vec3 const &right, glm::vec3 const &up) {
+	if (upload_clear) {
+		if (used_slots != 0) zero_buffers();
+		upload_clear = false;
+	}
+
+	//copy new particles over the oldest slots of the current buffer:
+	if (!upload.empty()) {
+		//(if more were emitted than fit, only the newest ones survive anyway)
+		uint32_t skip = uint32_t(std::max< size_t >(upload.size(), Capacity) - Capacity);
+		next_slot = (next_slot + skip) % Capacity;
+		glBindBuffer(GL_ARRAY_BUFFER, buffers[current]);
+		for (uint32_t i = skip; i < upload.size(); ) {
+			uint32_t count = std::min(uint32_t(upload.size()) - i, Capacity - next_slot);
+			glBufferSubData(GL_ARRAY_BUFFER, next_slot * sizeof(Particle), count * sizeof(Particle), &upload[i]);
+			used_slots = std::max(used_slots, next_slot + count);
+			next_slot = (next_slot + count) % Capacity;
+			i += count;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		upload.clear();
+	}
+
+	//nothing alive? nothing to do:
+	if (used_slots == 0 || !alive) {
+		upload_elapsed = 0.0f;
+		return;
+	}
+
+	{ //simulate, writing into the other buffer:
+		glEnable(GL_RASTERIZER_DISCARD);
+		glUseProgram(*particle_update_program);
+		glUniform1f(particle_update_program_elapsed_float, upload_elapsed);
+		glBindVertexArray(update_vaos[current]);
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[1 - current]);
+		glBeginTransformFeedback(GL_POINTS);
+		glDrawArrays(GL_POINTS, 0, GLsizei(used_slots));
+		glEndTransformFeedback();
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+		glDisable(GL_RASTERIZER_DISCARD);
+
+		current = 1 - current;
+		upload_elapsed = 0.0f;
+	}
+
+	{ //draw a quad per slot (dead particles are moved off-screen in the vertex shader):
+		glUseProgram(*particle_program);
+		glUniformMatrix4fv(particle_program_world_to_clip_mat4, 1, GL_FALSE, glm::value_ptr(world_to_clip));
+		glUniform3fv(particle_program_right_vec3, 1, glm::value_ptr(right));
+		glUniform3fv(particle_program_up_vec3, 1, glm::value_ptr(up));
+		glBindVertexArray(draw_vaos[current]);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(used_slots));
+	}
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+	GL_ERRORS();
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <random>
+
+#include "pcg32.hpp"
+
+//ParticleSystem keeps cosmetic particles (splashes, steam, sprinkles) entirely on the GPU:
+// particles live in a fixed-size ring of slots in a vertex buffer, and each frame a vertex shader
+// (dist/shaders/particle_update.vert) moves every particle forward, with transform feedback
+// writing the results to a second buffer; the two buffers then trade places.
+// Particles are drawn as camera-facing quads, one instance per slot (dist/shaders/particle.vert).
+//
+//New particles are queued by emit() and copied over the oldest slots before the next update,
+// so nothing is ever read back from the GPU. If more than 'Capacity' particles are alive at once,
+// the oldest ones just vanish early.
+//
+//emit/clear/update don't touch OpenGL, so they may be called from the simulation thread;
+// capture_draw_state() hands their results to draw() (see GameMode::capture_draw_state).
+//
+//Particles don't interact with anything -- gameplay objects belong in the Scene.
+struct ParticleSystem {
+	ParticleSystem();
+	~ParticleSystem();
+
+	//layout matches the vertex attributes in particle_update.vert:
+	struct Particle {
+		glm::vec3 position = glm::vec3(0.0f);
+		float life = 1.0f; //seconds left to live
+		glm::vec3 velocity = glm::vec3(0.0f);
+		float gravity = -30.0f; //acceleration along y
+		glm::vec4 color = glm::vec4(1.0f);
+		float size = 0.5f; //radius of the quad
+		float growth = 0.0f; //change in size per second
+		float drag = 0.0f; //fraction of velocity lost per second
+		float lifespan = 0.0f; //total life (set by emit; particles fade out over it)
+	};
+	static_assert(sizeof(Particle) == 4*16, "Particle is packed.");
+
+	//queue one particle:
+	void emit(Particle const &particle);
+
+	//queue 'count' copies of 'base', with position and velocity moved by up to +/- 'position_jitter' and
+	// 'velocity_jitter' (per axis) and life scaled by 0.75-1.25, so they don't all die together:
+	void emit_burst(uint32_t count, Particle const &base, glm::vec3 const &position_jitter, glm::vec3 const &velocity_jitter);
+
+	//remove all particles (e.g., when switching levels):
+	void clear();
+
+	//advance time; the simulation step itself runs in the next draw:
+	void update(float elapsed);
+
+	//pass everything emitted/cleared/elapsed so far along to the next draw:
+	void capture_draw_state();
+
+	//simulate and draw; 'right' and 'up' are the camera's axes in world space.
+	// Uses the current blend/depth state; leaves the vertex array and program unbound:
+	void draw(glm::mat4 const &world_to_clip, glm::vec3 const &right, glm::vec3 const &up);
+
+	static constexpr uint32_t Capacity = 16384;
+
+	GLuint buffers[2] = {0, 0}; //particle state; 'current' holds the latest
+	GLuint update_vaos[2] = {0, 0}; //read buffers[i] as per-vertex attributes (for the update step)
+	GLuint draw_vaos[2] = {0, 0}; //read buffers[i] as per-instance attributes (for drawing)
+	uint32_t current = 0;
+
+	//simulation side:
+	std::vector< Particle > pending; //emitted since the last capture (trimmed to the newest if nothing draws)
+	bool clear_pending = false; //clear() called since the last capture
+	float step_elapsed = 0.0f; //time since the last capture
+	float quiet = 0.0f; //time since anything was emitted
+	float longest_life = 0.0f; //longest life emitted; once 'quiet' passes this, all particles are dead
+
+	//draw side (filled by capture_draw_state):
+	std::vector< Particle > upload; //to copy into slots at the next draw
+	bool upload_clear = false; //empty every slot first
+	float upload_elapsed = 0.0f; //time not yet simulated
+	bool alive = false; //might anything be alive?
+	uint32_t next_slot = 0; //where the next emitted particle goes
+	uint32_t used_slots = 0; //slots that have ever held a particle (only these are updated/drawn)
+
+	//set every slot to a dead particle:
+	void zero_buffers();
+
+	PCG32 random; //(cosmetic only -- kept apart from GameMode::random so replays aren't affected)
+};
@@ -1,6 +1,8 @@
 #include "Portal.hpp"
 #include <glm/glm.hpp>
 
+#include <algorithm>
+
 using namespace glm;
 
 Portal::Portal() {
@@ -42,8 +44,16 @@ void Portal::rotate_to(vec2 const &target_normal) {
 }
 
 void Portal::update(float const elapsed) {
-    speed = (position - old_position) / elapsed;
-    old_position = position;
+    // mouse motion is handed over in the tick it happened in (see main.cpp), but not every tick gets some,
+    // so speed is the latest move over the time since the move before it (held in between)
+    since_move += elapsed;
+    if (position != old_position) {
+        speed = (position - old_position) / std::min(since_move, 0.05f);
+        old_position = position;
+        since_move = 0.0f;
+    } else if (since_move > 0.05f) {
+        speed = vec2(0.0f);  // stopped moving
+    }
 }
 
 void Portal::update_boundingbox() {
@@ -14,6 +14,7 @@ struct Portal {
 	glm::vec2 old_position;
 	glm::vec2 normal;
 	glm::vec2 speed;
+	float since_move = 0.0f; //time since position last changed
 
 	void move(glm::vec2 const &vec);
 	void rotate(float const &to_rot);
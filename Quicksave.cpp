@@ -0,0 +1,256 @@
+#include "Quicksave.hpp"
+
+#include "GameMode.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+//all of the structs below are plain data, copied with memcpy; bump this when any of them change:
+static constexpr uint32_t QuicksaveVersion = 2;
+
+namespace {
+
+struct Header {
+	uint32_t version;
+	uint32_t level;
+	uint32_t scene_loads;
+	uint32_t score_count;
+	uint32_t food_count;
+	uint32_t name_bytes; //food names, all run together
+	uint32_t level_bytes; //Level::save_state
+	float rot_speeds[2];
+	GameMode::RandomStreams random;
+};
+
+struct PortalState {
+	glm::vec2 position;
+	glm::vec2 old_position;
+	glm::vec2 normal;
+	glm::vec2 speed;
+	float since_move;
+};
+
+//(BoundingBox has constructors, so its fields are copied into a plain struct one at a time)
+struct BoundingBoxState {
+	float width, thickness;
+	glm::vec2 p0, parallel, normal;
+};
+
+struct FoodRecord {
+	glm::vec3 position;
+	glm::quat rotation;
+	glm::vec3 scale;
+	glm::vec2 speed;
+	float lifespan;
+	uint32_t portal_in; //0 for none, otherwise 1 + index into players
+	uint32_t has_boundingbox;
+	BoundingBoxState boundingbox;
+	uint32_t name_begin, name_end; //Scene::Object::data, as a range of the food names
+};
+
+template< typename T >
+void put(std::vector< uint8_t > *out, T const *values, size_t count) {
+	size_t at = out->size();
+	out->resize(at + sizeof(T) * count);
+	if (count) std::memcpy(out->data() + at, values, sizeof(T) * count);
+}
+
+struct Reader {
+	Reader(uint8_t const *data, size_t size) : at(data), end(data + size) { }
+
+	uint8_t const *take(size_t bytes) {
+		if (size_t(end - at) < bytes) throw std::runtime_error("Quicksave is truncated.");
+		uint8_t const *ret = at;
+		at += bytes;
+		return ret;
+	}
+	template< typename T >
+	void get(T *values, size_t count) {
+		uint8_t const *from = take(sizeof(T) * count);
+		if (count) std::memcpy(values, from, sizeof(T) * count);
+	}
+
+	uint8_t const *at;
+	uint8_t const *end;
+};
+
+}
+
+void capture_quicksave(GameMode const &gm, std::vector< uint8_t > *out) {
+	Header header;
+	header.version = QuicksaveVersion;
+	header.level = gm.level;
+	header.scene_loads = gm.scene_loads;
+	header.score_count = uint32_t(gm.scores.size());
+	header.food_count = uint32_t(gm.foods.size());
+	header.rot_speeds[0] = gm.rot_speeds[0];
+	header.rot_speeds[1] = gm.rot_speeds[1];
+	header.random = gm.random;
+
+	//(the header is filled in last, once the sizes of the variable-length parts are known)
+	size_t header_at = out->size();
+	size_t foods_at = header_at + sizeof(Header) + 2 * sizeof(PortalState) + header.score_count * sizeof(uint32_t);
+	size_t names_at = foods_at + header.food_count * sizeof(FoodRecord);
+	out->reserve(names_at + header.food_count * 16 + 4096); //(food names are short; a longer one just grows 'out')
+	out->resize(header_at + sizeof(Header));
+
+	for (uint32_t i = 0; i < 2; ++i) {
+		Portal const &player = gm.players[i];
+		PortalState portal;
+		portal.position = player.position;
+		portal.old_position = player.old_position;
+		portal.normal = player.normal;
+		portal.speed = player.speed;
+		portal.since_move = player.since_move;
+		put(out, &portal, 1);
+	}
+	put(out, gm.scores.data(), gm.scores.size());
+
+	//food records are written in place, and their names appended after them:
+	// (by offset, since appending may move 'out')
+	out->resize(names_at);
+	size_t record_at = foods_at;
+	for (Scene::Object const *obj : gm.foods) {
+		Scene::Transform const *transform = obj->transform;
+		FoodRecord food;
+		food.position = transform->position;
+		food.rotation = transform->rotation;
+		food.scale = transform->scale;
+		food.speed = transform->speed;
+		food.lifespan = obj->lifespan;
+		food.portal_in = 0;
+		for (uint32_t i = 0; i < 2; ++i) {
+			if (obj->portal_in == &gm.players[i]) food.portal_in = 1 + i;
+		}
+		food.has_boundingbox = (transform->boundingbox != nullptr);
+		if (BoundingBox const *box = transform->boundingbox) {
+			food.boundingbox.width = box->width;
+			food.boundingbox.thickness = box->thickness;
+			food.boundingbox.p0 = box->p0;
+			food.boundingbox.parallel = box->parallel;
+			food.boundingbox.normal = box->normal;
+		} else {
+			food.boundingbox = BoundingBoxState();
+		}
+		food.name_begin = uint32_t(out->size() - names_at);
+		out->insert(out->end(), obj->data.begin(), obj->data.end());
+		food.name_end = uint32_t(out->size() - names_at);
+		std::memcpy(out->data() + record_at, &food, sizeof(FoodRecord));
+		record_at += sizeof(FoodRecord);
+	}
+	header.name_bytes = uint32_t(out->size() - names_at);
+
+	size_t level_at = out->size();
+	gm.current_level->save_state(out);
+	header.level_bytes = uint32_t(out->size() - level_at);
+
+	std::memcpy(out->data() + header_at, &header, sizeof(Header));
+}
+
+void restore_quicksave(GameMode *gm, uint8_t const *data, size_t size) {
+	//read and check everything that can be checked before changing anything, so bad data leaves the game as it was:
+	// (the level's own state can only be checked by the level load_scene makes -- see below)
+	Reader reader(data, size);
+	Header header;
+	reader.get(&header, 1);
+	if (header.version != QuicksaveVersion) {
+		throw std::runtime_error("Quicksave has layout version " + std::to_string(header.version) + "; expected " + std::to_string(QuicksaveVersion) + ".");
+	}
+	if (header.score_count != gm->scores.size()) {
+		throw std::runtime_error("Quicksave has " + std::to_string(header.score_count) + " scores; expected " + std::to_string(gm->scores.size()) + ".");
+	}
+	PortalState portals[2];
+	reader.get(portals, 2);
+	std::vector< uint32_t > scores(header.score_count);
+	reader.get(scores.data(), scores.size());
+	//(food records are read where they are, one at a time, rather than copied out all together)
+	uint8_t const *records = reader.take(size_t(header.food_count) * sizeof(FoodRecord));
+	auto get_food = [records](uint32_t i, FoodRecord *food) {
+		std::memcpy(food, records + size_t(i) * sizeof(FoodRecord), sizeof(FoodRecord));
+	};
+	char const *names = reinterpret_cast< char const * >(reader.take(header.name_bytes));
+	uint8_t const *level_state = reader.take(header.level_bytes);
+	if (reader.at != reader.end) throw std::runtime_error("Quicksave has extra data at the end.");
+
+	for (uint32_t i = 0; i < header.food_count; ++i) {
+		FoodRecord food;
+		get_food(i, &food);
+		if (food.name_begin > food.name_end || food.name_end > header.name_bytes || food.portal_in > 2) {
+			throw std::runtime_error("Quicksave has a damaged food record.");
+		}
+	}
+
+	//start the level over, then move everything to where it was:
+	gm->level = header.level;
+	gm->load_scene();
+	//(checked first, so a mismatch leaves the level just started over rather than partly restored)
+	if (!gm->current_level->restore_state(level_state, header.level_bytes)) {
+		throw std::runtime_error("Quicksave's level state doesn't match level " + std::to_string(header.level) + ".");
+	}
+	gm->scene_loads = header.scene_loads;
+	gm->random = header.random;
+	gm->scores = scores;
+
+	for (uint32_t i = 0; i < 2; ++i) {
+		Portal &player = gm->players[i];
+		player.move_to(portals[i].position);
+		player.rotate_to(portals[i].normal);
+		player.old_position = portals[i].old_position;
+		player.speed = portals[i].speed;
+		player.since_move = portals[i].since_move;
+		gm->rot_speeds[i] = header.rot_speeds[i];
+	}
+
+	//foods the level made when it started (e.g., the oven's steak) stand in for the first saved foods;
+	// the level makes the rest (all at once), as it would have spawned them:
+	std::vector< Scene::Object * > existing(gm->foods.begin(), gm->foods.end());
+	uint32_t reused = std::min(header.food_count, uint32_t(existing.size()));
+	std::vector< Scene::Object * > objs(existing.begin(), existing.begin() + reused);
+	{
+		std::vector< std::string > wanted;
+		wanted.reserve(header.food_count - reused);
+		for (uint32_t i = reused; i < header.food_count; ++i) {
+			FoodRecord food;
+			get_food(i, &food);
+			wanted.emplace_back(names + food.name_begin, names + food.name_end);
+		}
+		gm->current_level->add_foods(wanted, &objs); //(makes none if this level doesn't spawn foods)
+	}
+	for (uint32_t i = 0; i < objs.size(); ++i) {
+		FoodRecord food;
+		get_food(i, &food);
+		Scene::Object *obj = objs[i];
+		Scene::Transform *transform = obj->transform;
+		transform->position = food.position;
+		transform->rotation = food.rotation;
+		transform->scale = food.scale;
+		transform->speed = food.speed;
+		obj->lifespan = food.lifespan;
+		if (food.has_boundingbox) {
+			if (!transform->boundingbox) transform->boundingbox = new BoundingBox();
+			BoundingBox *box = transform->boundingbox;
+			box->width = food.boundingbox.width;
+			box->thickness = food.boundingbox.thickness;
+			box->p0 = food.boundingbox.p0;
+			box->parallel = food.boundingbox.parallel;
+			box->normal = food.boundingbox.normal;
+		}
+		if (food.portal_in) {
+			obj->portal_in = &gm->players[food.portal_in - 1];
+			obj->portal_in->vicinity.insert(obj);
+		}
+	}
+	//...and any it made beyond those were gone by the time of the save:
+	// (delete_* only unlink, so these are freed here -- object first, since it points at its transform)
+	for (uint32_t i = reused; i < existing.size(); ++i) {
+		Scene::Object *obj = existing[i];
+		Scene::Transform *transform = obj->transform;
+		gm->foods.remove(obj);
+		gm->scene->delete_object(obj);
+		delete obj;
+		gm->scene->delete_transform(transform);
+		delete transform; //(and its bounding box)
+	}
+}
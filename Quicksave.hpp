@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct GameMode;
+
+//A "quicksave" is an exact copy of a level in progress: level number, scores, portals (and the
+// rotation buttons held), every food (transform, speed, bounding box, lifespan, which portal's
+// vicinity it is in), the level's own timers and counters (Level::save_state), and GameMode::random.
+//(particles are cosmetic and aren't kept)
+//
+//It is one flat block rather than a stream of per-object records:
+// header (including GameMode::random) | portals[2] | scores[] | foods[] | food names | level state
+//where the fixed-size parts are plain structs copied in and out with memcpy. The layout is the
+// in-memory one on a little-endian machine, so quicksaves aren't meant to move between platforms.
+//
+//(Snapshot.hpp is the lossy, quantized cousin used for networking and replays.)
+
+//append a quicksave of 'gm' to 'out':
+void capture_quicksave(GameMode const &gm, std::vector< uint8_t > *out);
+
+//reload the saved level (with load_scene) and put it back the way it was:
+// note: throws if the data isn't a quicksave (or is from a different layout version) -- before anything
+// changes, unless it's the level's own state that doesn't fit; that's found once load_scene has started the
+// saved level over, which is then left as it started.
+void restore_quicksave(GameMode *gm, uint8_t const *data, size_t size);
@@ -1,47 +1,402 @@
 #include "Save.hpp"
 
-#include "read_chunk.hpp"
+#include "data_path.hpp"
 
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <cstring>
+#include <cstdio>
 
-using namespace std;
-void save(uint32_t saveNum, uint32_t level, vector <uint32_t> const &scores){
-    cout<<"Saving to save "<<saveNum<<endl;
-    ofstream saveFile;
-    saveFile.open("saves/save"+to_string(saveNum)+".txt", std::ofstream::trunc);
-    saveFile<<to_string(level)<<"\n";
-    for(uint32_t i = 0; i<scores.size(); i++){
-        saveFile<<to_string(scores[i])<<"\n";
-    }
-    saveFile.close();
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr uint32_t SaveVersion = 1;
+
+static std::string save_path(uint32_t saveNum) {
+	return data_path("saves/save" + std::to_string(saveNum) + ".bin");
+}
+
+//------------ encoding ------------
+
+static uint32_t crc32(uint8_t const *data, size_t size) {
+	static uint32_t table[256];
+	static bool table_ready = [](){
+		for (uint32_t i = 0; i < 256; ++i) {
+			uint32_t c = i;
+			for (uint32_t k = 0; k < 8; ++k) {
+				c = (c & 1) ? (0xedb88320U ^ (c >> 1)) : (c >> 1);
+			}
+			table[i] = c;
+		}
+		return true;
+	}();
+	(void)table_ready;
+
+	uint32_t crc = 0xffffffffU;
+	for (size_t i = 0; i < size; ++i) {
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return crc ^ 0xffffffffU;
+}
+
+static void put_u32(std::vector< uint8_t > &out, uint32_t v) {
+	for (uint32_t i = 0; i < 4; ++i) {
+		out.emplace_back(uint8_t(v >> (8 * i)));
+	}
+}
+
+static uint32_t get_u32(uint8_t const *at) {
+	return uint32_t(at[0]) | (uint32_t(at[1]) << 8) | (uint32_t(at[2]) << 16) | (uint32_t(at[3]) << 24);
+}
+
+static void put_chunk(std::vector< uint8_t > &out, std::string const &magic, std::vector< uint8_t > const &data) {
+	if (magic.size() != 4) throw std::runtime_error("Save chunk magic '" + magic + "' isn't four characters.");
+	out.insert(out.end(), magic.begin(), magic.end());
+	put_u32(out, uint32_t(data.size()));
+	out.insert(out.end(), data.begin(), data.end());
+}
+
+static std::vector< uint8_t > encode(SaveData const &data) {
+	std::vector< uint8_t > chunks;
+	{
+		std::vector< uint8_t > level;
+		put_u32(level, data.currentLevel);
+		put_chunk(chunks, "levl", level);
+	}
+	{
+		std::vector< uint8_t > best;
+		for (uint32_t score : data.personalBests) {
+			put_u32(best, score);
+		}
+		put_chunk(chunks, "best", best);
+	}
+	for (auto const &chunk : data.chunks) {
+		put_chunk(chunks, chunk.magic, chunk.data);
+	}
+
+	std::vector< uint8_t > out;
+	out.reserve(12 + chunks.size() + 4);
+	out.insert(out.end(), {'p', 's', 'a', 'v'});
+	put_u32(out, SaveVersion);
+	put_u32(out, uint32_t(chunks.size()));
+	out.insert(out.end(), chunks.begin(), chunks.end());
+	put_u32(out, crc32(out.data(), out.size()));
+	return out;
+}
+
+//throws if the data isn't a complete, undamaged save:
+static SaveData decode(uint8_t const *bytes, size_t size) {
+	if (size < 16 || std::memcmp(bytes, "psav", 4) != 0) {
+		throw std::runtime_error("not a save file");
+	}
+	uint32_t version = get_u32(bytes + 4);
+	if (version != SaveVersion) {
+		throw std::runtime_error("save has version " + std::to_string(version) + "; expected " + std::to_string(SaveVersion));
+	}
+	uint32_t length = get_u32(bytes + 8);
+	if (size != 12 + size_t(length) + 4) {
+		throw std::runtime_error("save is truncated");
+	}
+	if (crc32(bytes, 12 + length) != get_u32(bytes + 12 + length)) {
+		throw std::runtime_error("save checksum doesn't match");
+	}
+
+	SaveData data;
+	uint8_t const *at = bytes + 12;
+	uint8_t const *end = at + length;
+	while (at < end) {
+		if (end - at < 8) throw std::runtime_error("save has a truncated chunk header");
+		std::string magic(reinterpret_cast< char const * >(at), 4);
+		uint32_t chunk_size = get_u32(at + 4);
+		at += 8;
+		if (uint32_t(end - at) < chunk_size) throw std::runtime_error("save chunk '" + magic + "' is truncated");
+
+		if (magic == "levl" && chunk_size == 4) {
+			data.currentLevel = get_u32(at);
+		} else if (magic == "best" && chunk_size % 4 == 0) {
+			data.personalBests.clear();
+			for (uint32_t i = 0; i < chunk_size; i += 4) {
+				data.personalBests.emplace_back(get_u32(at + i));
+			}
+		} else {
+			data.chunks.emplace_back();
+			data.chunks.back().magic = magic;
+			data.chunks.back().data.assign(at, at + chunk_size);
+		}
+		at += chunk_size;
+	}
+	return data;
+}
+
+//------------ reading ------------
+
+//read-only view of a whole file, memory-mapped:
+struct MappedFile {
+	MappedFile(std::string const &path) {
+#if defined(_WIN32)
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) return;
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) return;
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL) return;
+		void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == NULL) return;
+		data = reinterpret_cast< uint8_t const * >(view);
+		size = size_t(file_size.QuadPart);
+#else
+		int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return;
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0) {
+			void *view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view != MAP_FAILED) {
+				data = reinterpret_cast< uint8_t const * >(view);
+				size = size_t(info.st_size);
+			}
+		}
+		close(fd); //(the mapping stays valid)
+#endif
+	}
+	~MappedFile() {
+#if defined(_WIN32)
+		if (data) UnmapViewOfFile(data);
+		if (mapping != NULL) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+		if (data) munmap(const_cast< uint8_t * >(data), size);
+#endif
+	}
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	uint8_t const *data = nullptr; //null if the file couldn't be opened (or is empty)
+	size_t size = 0;
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+#endif
+};
+
+//text saves from before the binary format: level, then one personal best per line
+// (they were written relative to the working directory, so look there as well as next to the executable):
+static bool load_legacy(uint32_t saveNum, SaveData *data) {
+	std::string name = "saves/save" + std::to_string(saveNum) + ".txt";
+	for (std::string const &path : {data_path(name), name}) {
+		std::ifstream file(path);
+		if (!file) continue;
+		SaveData loaded;
+		if (!(file >> loaded.currentLevel)) continue;
+		uint32_t score;
+		while (file >> score) {
+			loaded.personalBests.emplace_back(score);
+		}
+		std::cout << "Converting old save '" << path << "'." << std::endl;
+		*data = loaded;
+		return true;
+	}
+	return false;
+}
+
+//------------ writing ------------
+
+//write 'bytes' to 'path' through a temporary file, so the old file is replaced all at once:
+static void write_atomically(std::string const &path, std::vector< uint8_t > const &bytes) {
+	std::string temp = path + ".tmp";
+#if defined(_WIN32)
+	{
+		HANDLE file = CreateFileA(temp.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Failed to create '" + temp + "'.");
+		DWORD written = 0;
+		bool ok = WriteFile(file, bytes.data(), DWORD(bytes.size()), &written, NULL) && written == bytes.size();
+		ok = ok && FlushFileBuffers(file);
+		CloseHandle(file);
+		if (!ok) throw std::runtime_error("Failed to write '" + temp + "'.");
+	}
+	if (!MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+		throw std::runtime_error("Failed to replace '" + path + "'.");
+	}
+#else
+	int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) throw std::runtime_error("Failed to create '" + temp + "'.");
+	size_t done = 0;
+	while (done < bytes.size()) {
+		ssize_t wrote = write(fd, bytes.data() + done, bytes.size() - done);
+		if (wrote <= 0) break;
+		done += size_t(wrote);
+	}
+	bool ok = (done == bytes.size()) && fsync(fd) == 0;
+	close(fd);
+	if (!ok) throw std::runtime_error("Failed to write '" + temp + "'.");
+	if (rename(temp.c_str(), path.c_str()) != 0) {
+		throw std::runtime_error("Failed to replace '" + path + "'.");
+	}
+	//make the rename itself durable:
+	std::string dir = path.substr(0, path.rfind('/'));
+	int dir_fd = open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+	if (dir_fd >= 0) {
+		fsync(dir_fd);
+		close(dir_fd);
+	}
+#endif
+}
+
+static void make_saves_directory() {
+	std::string dir = data_path("saves");
+#if defined(_WIN32)
+	CreateDirectoryA(dir.c_str(), NULL);
+#else
+	mkdir(dir.c_str(), 0755);
+#endif
 }
 
-/*
- * struct SaveData {
- *     uint32_t currentLevel = 0;
- *     std::vector <uint32_t> personalBests;
- * };
-*/
+//SaveWriter writes queued saves on its own thread; if a file is saved again before the
+// earlier save is written, only the newer one is written:
+struct SaveWriter {
+	std::mutex mutex;
+	std::condition_variable wake; //signalled when a save is queued or on shutdown
+	std::condition_variable idle; //signalled when the queue empties
+	std::map< std::string, std::vector< uint8_t > > queued; //path -> contents
+	bool writing = false;
+	bool quit = false;
+	std::thread thread;
 
-//referenced this https://www.geeksforgeeks.org/cpp-program-read-file-word-word/
-SaveData LoadSave(uint32_t saveNumber){
-    SaveData loaded;
-    string line;
-    string filename = "saves/save"+to_string(saveNumber)+".txt";
+	SaveWriter() {
+		thread = std::thread(&SaveWriter::main, this);
+	}
+	~SaveWriter() {
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		thread.join();
+	}
 
-    fstream file;
-    file.open(filename.c_str());
+	void main() {
+		make_saves_directory();
+		std::unique_lock< std::mutex > lock(mutex);
+		while (true) {
+			wake.wait(lock, [this](){ return quit || !queued.empty(); });
+			if (queued.empty()) break; //(quit, with everything written)
+			std::string path = queued.begin()->first;
+			std::vector< uint8_t > bytes;
+			std::swap(bytes, queued.begin()->second);
+			queued.erase(queued.begin());
+			writing = true;
+			lock.unlock();
 
-    //uint32_t level;
-    file>>loaded.currentLevel;
+			try {
+				write_atomically(path, bytes);
+			} catch (std::exception &e) {
+				std::cerr << "Failed to save: " << e.what() << std::endl;
+			}
 
-    uint32_t score;
-    while(file>>score){
-        loaded.personalBests.emplace_back(score);
-    }
-    return loaded;
+			lock.lock();
+			writing = false;
+			if (queued.empty()) idle.notify_all();
+		}
+	}
+
+	void queue(std::string const &path, std::vector< uint8_t > &&bytes) {
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			queued[path] = std::move(bytes);
+		}
+		wake.notify_all();
+	}
+
+	//contents queued for 'path', if any:
+	bool pending(std::string const &path, std::vector< uint8_t > *bytes) {
+		std::unique_lock< std::mutex > lock(mutex);
+		auto f = queued.find(path);
+		if (f == queued.end()) return false;
+		*bytes = f->second;
+		return true;
+	}
+
+	void finish() {
+		std::unique_lock< std::mutex > lock(mutex);
+		idle.wait(lock, [this](){ return queued.empty() && !writing; });
+	}
+};
+
+static SaveWriter &save_writer() {
+	static SaveWriter writer; //(joined at exit, after writing anything still queued)
+	return writer;
 }
 
+//------------------------
+
+SaveData::Chunk const *SaveData::find_chunk(std::string const &magic) const {
+	for (auto const &chunk : chunks) {
+		if (chunk.magic == magic) return &chunk;
+	}
+	return nullptr;
+}
+
+void SaveData::set_chunk(std::string const &magic, std::vector< uint8_t > const &data) {
+	for (auto &chunk : chunks) {
+		if (chunk.magic == magic) {
+			chunk.data = data;
+			return;
+		}
+	}
+	chunks.emplace_back();
+	chunks.back().magic = magic;
+	chunks.back().data = data;
+}
+
+void save(uint32_t saveNum, SaveData const &data) {
+	std::cout << "Saving to save " << saveNum << std::endl;
+	save_writer().queue(save_path(saveNum), encode(data));
+}
+
+void save(uint32_t saveNum, uint32_t level, std::vector <uint32_t> const &scores) {
+	SaveData data = LoadSave(saveNum); //(keeps any other chunks)
+	data.currentLevel = level;
+	data.personalBests = scores;
+	save(saveNum, data);
+}
+
+SaveData LoadSave(uint32_t saveNumber) {
+	std::string path = save_path(saveNumber);
+	try {
+		std::vector< uint8_t > queued;
+		if (save_writer().pending(path, &queued)) {
+			return decode(queued.data(), queued.size());
+		}
+		MappedFile file(path);
+		if (file.data) {
+			return decode(file.data, file.size);
+		}
+	} catch (std::exception &e) {
+		std::cerr << "Ignoring save '" << path << "': " << e.what() << "." << std::endl;
+		return SaveData();
+	}
+
+	SaveData legacy;
+	if (load_legacy(saveNumber, &legacy)) {
+		save(saveNumber, legacy); //(convert it, so this only happens once)
+		return legacy;
+	}
+	return SaveData();
+}
+
+void finish_saves() {
+	save_writer().finish();
+}
@@ -1,15 +1,48 @@
 #pragma once
 
 #include <stdint.h>
+#include <string>
 #include <vector>
 
+//Save files live in data_path("saves/saveN.bin"). Layout (all integers little-endian):
+// header: "psav", version (uint32), size of the chunks that follow (uint32)
+// chunks: magic (4 chars), size (uint32), 'size' bytes of data
+// footer: CRC-32 of everything before it (uint32)
+//Chunks this version writes:
+// "levl" -- current level (uint32)
+// "best" -- personal best score for each level (uint32 each)
+// "game" -- a level in progress, if saved from the pause menu (see Quicksave.hpp)
+//Readers skip chunks they don't know, and chunks that aren't read are written back unchanged,
+// so more state can be added as new chunks.
+//
+//Text saves from older versions ("saves/saveN.txt") are read if there's no binary save yet.
 
 struct SaveData {
-    uint32_t currentLevel = 0;
-    std::vector <uint32_t> personalBests;
+	uint32_t currentLevel = 0;
+	std::vector <uint32_t> personalBests;
+
+	//chunks not listed above:
+	struct Chunk {
+		std::string magic;
+		std::vector< uint8_t > data;
+	};
+	std::vector< Chunk > chunks;
+
+	//chunk with the given magic, or nullptr if there isn't one:
+	Chunk const *find_chunk(std::string const &magic) const;
+	//replace (or add) the chunk with the given magic:
+	void set_chunk(std::string const &magic, std::vector< uint8_t > const &data);
 };
 
+//queue a save to be written by the save thread, replacing the file all at once
+// (written to a temporary file, flushed to disk, then renamed over the old one),
+// so a crash mid-save leaves either the old or the new save -- never part of one:
+void save(uint32_t saveNum, SaveData const &data);
 void save(uint32_t saveNum,
         uint32_t level, std::vector <uint32_t> const &scores);
 
+//read a save (including any queued but not yet written); a missing or damaged save reads as empty:
 SaveData LoadSave(uint32_t saveNumber);
+
+//wait for queued saves to be written (call before exiting):
+void finish_saves();
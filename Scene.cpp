@@ -1,11 +1,13 @@
 #include "Scene.hpp"
 #include "read_chunk.hpp"
+#include "uniform_blocks.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
 #include <fstream>
+#include <cmath>
 
 glm::mat4 Scene::Transform::make_local_to_parent() const {
 	return glm::mat4( //translate
@@ -59,6 +61,44 @@ glm::mat4 Scene::Transform::make_world_to_local() const {
 	}
 }
 
+void Scene::Transform::make_world_bounds(glm::vec3 const &local_min, glm::vec3 const &local_max, glm::vec3 *world_min, glm::vec3 *world_max) const {
+	BoundsCache &cache = bounds_cache;
+	if (!parent && cache.valid
+	 && cache.position == position && cache.rotation == rotation && cache.scale == scale
+	 && cache.local_min == local_min && cache.local_max == local_max) {
+		*world_min = cache.world_min;
+		*world_max = cache.world_max;
+		return;
+	}
+
+	//transform the box's center, and its half-extents by the absolute value of the matrix (Arvo's method):
+	glm::mat4 local_to_world = make_local_to_world();
+	glm::vec3 center = 0.5f * (local_min + local_max);
+	glm::vec3 half = 0.5f * (local_max - local_min);
+	glm::vec3 world_center, world_half;
+	for (uint32_t r = 0; r < 3; ++r) {
+		world_center[r] = local_to_world[3][r];
+		world_half[r] = 0.0f;
+		for (uint32_t c = 0; c < 3; ++c) {
+			world_center[r] += local_to_world[c][r] * center[c];
+			world_half[r] += std::abs(local_to_world[c][r]) * half[c];
+		}
+	}
+	*world_min = world_center - world_half;
+	*world_max = world_center + world_half;
+
+	if (!parent) {
+		cache.valid = true;
+		cache.position = position;
+		cache.rotation = rotation;
+		cache.scale = scale;
+		cache.local_min = local_min;
+		cache.local_max = local_max;
+		cache.world_min = *world_min;
+		cache.world_max = *world_max;
+	}
+}
+
 void Scene::Transform::DEBUG_assert_valid_pointers() const {
 	if (parent == nullptr) {
 		//if no parent, can't have siblings:
@@ -155,7 +195,9 @@ void Scene::delete_transform(Scene::Transform *transform) {
 
 Scene::Object *Scene::new_object(Scene::Transform *transform) {
 	assert(transform && "Scene::Object must be attached to a transform.");
-	return list_new< Scene::Object >(first_object, transform);
+	Scene::Object *object = list_new< Scene::Object >(first_object, transform);
+	object->id = next_object_id++;
+	return object;
 }
 
 void Scene::delete_object(Scene::Object *object) {
@@ -180,6 +222,128 @@ void Scene::delete_camera(Scene::Camera *object) {
 	list_delete< Scene::Camera >(object);
 }
 
+void Scene::store_tick_state() {
+	for (Scene::Transform *t = first_transform; t != nullptr; t = t->alloc_next) {
+		t->tick_state.valid = true;
+		t->tick_state.position = t->position;
+		t->tick_state.rotation = t->rotation;
+		t->tick_state.scale = t->scale;
+	}
+}
+
+void Scene::interpolate(float alpha) {
+	for (Scene::Transform *t = first_transform; t != nullptr; t = t->alloc_next) {
+		if (!t->tick_state.valid) continue;
+		t->position = glm::mix(t->tick_state.position, t->position, alpha);
+		t->rotation = glm::slerp(t->tick_state.rotation, t->rotation, alpha);
+		t->scale = glm::mix(t->tick_state.scale, t->scale, alpha);
+	}
+}
+
+template< typename T >
+static uint32_t list_count(T const *first) {
+	uint32_t count = 0;
+	for (T const *t = first; t != nullptr; t = t->alloc_next) {
+		++count;
+	}
+	return count;
+}
+
+//copy 'from' over 'to' (objects, lamps, cameras), keeping 'to's place in its scene's list:
+template< typename T >
+static void copy_keeping_links(T const &from, T *to, Scene::CopyMap const &copies) {
+	T **alloc_prev_next = to->alloc_prev_next;
+	T *alloc_next = to->alloc_next;
+	*to = from;
+	to->alloc_prev_next = alloc_prev_next;
+	to->alloc_next = alloc_next;
+	to->transform = copies.at(from.transform);
+}
+
+void Scene::copy_from(Scene const &other, CopyMap *copies) {
+	assert(copies);
+	copies->transforms.clear();
+	copies->objects.clear();
+	copies->lamps.clear();
+	copies->cameras.clear();
+	//(clear() keeps the arrays' capacity, so after the first few frames nothing here allocates)
+
+	//match the number of things in each list (extras are removed from the front; new ones are added there).
+	//objects, lamps, and cameras go first, so no transform is freed while still in use:
+	//(new ones are attached to any transform for now; copying fixes that below)
+	auto match_count = [](uint32_t want, uint32_t have, std::function< void() > const &add, std::function< void() > const &remove) {
+		for (; have < want; ++have) add();
+		for (; have > want; --have) remove();
+	};
+	match_count(list_count(other.first_camera), list_count(first_camera),
+		[this](){ new_camera(first_transform ? first_transform : new_transform()); },
+		[this](){ Camera *c = first_camera; delete_camera(c); delete c; });
+	match_count(list_count(other.first_lamp), list_count(first_lamp),
+		[this](){ new_lamp(first_transform ? first_transform : new_transform()); },
+		[this](){ Lamp *l = first_lamp; delete_lamp(l); delete l; });
+	match_count(list_count(other.first_object), list_count(first_object),
+		[this](){ new_object(first_transform ? first_transform : new_transform()); },
+		[this](){ Object *o = first_object; delete_object(o); delete o; });
+	//(detach the hierarchy so it can be rebuilt to match, and so freeing a transform doesn't touch others)
+	for (Transform *t = first_transform; t != nullptr; t = t->alloc_next) {
+		while (t->last_child) t->last_child->set_parent(nullptr);
+		if (t->parent) t->set_parent(nullptr);
+	}
+	match_count(list_count(other.first_transform), list_count(first_transform),
+		[this](){ new_transform(); },
+		[this](){ Transform *t = first_transform; delete_transform(t); delete t; });
+
+	//copy transforms (lists now line up one-to-one):
+	Transform *to = first_transform;
+	for (Transform const *from = other.first_transform; from != nullptr; from = from->alloc_next, to = to->alloc_next) {
+		to->name = from->name;
+		to->position = from->position;
+		to->rotation = from->rotation;
+		to->scale = from->scale;
+		to->speed = from->speed;
+		to->tick_state = from->tick_state;
+		to->bounds_cache = from->bounds_cache;
+		from->copy_index = uint32_t(copies->transforms.size());
+		copies->transforms.emplace_back(to);
+	}
+	//rebuild the hierarchy, keeping child order (set_parent without 'before' appends, so walk each child list from the front):
+	for (Transform const *from = other.first_transform; from != nullptr; from = from->alloc_next) {
+		if (!from->last_child) continue;
+		Transform const *first_child = from->last_child;
+		while (first_child->prev_sibling) first_child = first_child->prev_sibling;
+		Transform *parent = copies->at(from);
+		for (Transform const *c = first_child; c != nullptr; c = c->next_sibling) {
+			copies->at(c)->set_parent(parent);
+		}
+	}
+
+	Object *to_object = first_object;
+	for (Object const *from = other.first_object; from != nullptr; from = from->alloc_next) {
+		copy_keeping_links(*from, to_object, *copies);
+		to_object->portal_in = nullptr;
+		from->copy_index = uint32_t(copies->objects.size());
+		copies->objects.emplace_back(to_object);
+		to_object = to_object->alloc_next;
+	}
+	next_object_id = other.next_object_id;
+
+	Lamp *to_lamp = first_lamp;
+	for (Lamp const *from = other.first_lamp; from != nullptr; from = from->alloc_next) {
+		copy_keeping_links(*from, to_lamp, *copies);
+		from->copy_index = uint32_t(copies->lamps.size());
+		copies->lamps.emplace_back(to_lamp);
+		to_lamp = to_lamp->alloc_next;
+	}
+
+	Camera *to_camera = first_camera;
+	for (Camera const *from = other.first_camera; from != nullptr; from = from->alloc_next) {
+		copy_keeping_links(*from, to_camera, *copies);
+		from->copy_index = uint32_t(copies->cameras.size());
+		copies->cameras.emplace_back(to_camera);
+		to_camera = to_camera->alloc_next;
+	}
+}
+
 void Scene::draw(Scene::Camera const *camera, Object::ProgramType program_type, Portal *portal) const {
 	assert(camera && "Must have a camera to draw scene from.");
 	assert(program_type < Object::ProgramTypes);
@@ -202,9 +366,72 @@ void Scene::draw(Scene::Lamp const *lamp, Object::ProgramType program_type) cons
 }
 
 
+//ViewVolume decides which objects can't possibly be seen in a draw call:
+struct ViewVolume {
+	//planes of the view frustum, from the rows of world_to_clip (Gribb & Hartmann):
+	// a point p is inside when dot(plane, vec4(p, 1)) >= 0 for all six.
+	glm::vec4 planes[6];
+
+	//for portal passes, GameMode's portal_depth_program covers everything behind the portal with a quad at
+	// the near plane; that's the region dot(portal_normal, p.xy) < portal_offset (within 'portal_reach' of it):
+	bool portal_pass = false;
+	glm::vec2 portal_normal = glm::vec2(0.0f);
+	float portal_offset = 0.0f;
+	static constexpr float portal_reach = 1000.0f; //(size of the blocker quad)
+
+	ViewVolume(glm::mat4 const &world_to_clip, Portal const *portal) {
+		glm::vec4 rows[4];
+		for (uint32_t r = 0; r < 4; ++r) {
+			rows[r] = glm::vec4(world_to_clip[0][r], world_to_clip[1][r], world_to_clip[2][r], world_to_clip[3][r]);
+		}
+		for (uint32_t i = 0; i < 3; ++i) {
+			planes[2*i+0] = rows[3] + rows[i];
+			planes[2*i+1] = rows[3] - rows[i];
+		}
+
+		//(the blocker is only at the near plane for orthographic projections -- like GameMode's camera -- where clip w is always 1)
+		bool orthographic = (rows[3] == glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		if (portal && orthographic) {
+			glm::mat4 portal_to_world = portal->portal_transform->make_local_to_world();
+			glm::vec2 at = glm::vec2(portal_to_world[3].x, portal_to_world[3].y);
+			portal_pass = true;
+			portal_normal = portal->normal;
+			portal_offset = glm::dot(portal_normal, at - 2.5f * portal_normal); //(the shader pulls the blocker back by 2.5 units)
+		}
+	}
+
+	bool visible(Scene::Object const &object) const {
+		if (object.mesh_min == object.mesh_max) return true; //no bounds given
+		glm::vec3 min, max;
+		object.transform->make_world_bounds(object.mesh_min, object.mesh_max, &min, &max);
+
+		for (auto const &plane : planes) {
+			//corner of the box furthest along the plane's normal:
+			glm::vec3 corner = glm::vec3(
+				(plane.x >= 0.0f ? max.x : min.x),
+				(plane.y >= 0.0f ? max.y : min.y),
+				(plane.z >= 0.0f ? max.z : min.z)
+			);
+			if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f) return false;
+		}
+
+		if (portal_pass) {
+			//range of dot(portal_normal, p.xy) over the box:
+			float center = portal_normal.x * 0.5f * (min.x + max.x) + portal_normal.y * 0.5f * (min.y + max.y);
+			float radius = std::abs(portal_normal.x) * 0.5f * (max.x - min.x) + std::abs(portal_normal.y) * 0.5f * (max.y - min.y);
+			if (center + radius < portal_offset && center - radius > portal_offset - portal_reach) return false;
+		}
+		return true;
+	}
+};
+
 void Scene::draw(glm::mat4 const &world_to_clip, Object::ProgramType program_type, Portal *portal) const {
 	assert(program_type < Object::ProgramTypes);
 
+	ViewVolume view(world_to_clip, portal);
+
+	static std::vector< Object const * > objects; //(static to avoid re-allocating every call)
+	objects.clear();
 	for (Scene::Object *object = first_object; object != nullptr; object = object->alloc_next) {
 
 		// Only draw if in specific portal, or in no portal
@@ -213,52 +440,128 @@ void Scene::draw(glm::mat4 const &world_to_clip, Object::ProgramType program_typ
 		}
 
 		//don't draw if no program of this type attached to object:
-		if (object->programs[program_type].program == 0) continue;
+		if (object->programs[program_type].program == nullptr) continue;
 
-		glm::mat4 local_to_world = object->transform->make_local_to_world();
+		if (!view.visible(*object)) {
+			draw_stats.culled += 1;
+			continue;
+		}
 
-		//compute modelview+projection (object space to clip space) matrix for this object:
-		glm::mat4 mvp = world_to_clip * local_to_world;
+		objects.emplace_back(object);
+	}
 
-		//compute modelview (object space to camera local space) matrix for this object:
-		glm::mat4x3 mv = glm::mat4x3(local_to_world);
+	draw_objects(objects, world_to_clip, program_type);
+}
 
-		//NOTE: inverse cancels out transpose unless there is scale involved
-		glm::mat3 itmv = glm::inverse(glm::transpose(glm::mat3(mv)));
+void Scene::draw_if(glm::mat4 const &world_to_clip, Object::ProgramType program_type, std::function< bool(Object const &) > const &include) const {
+	assert(program_type < Object::ProgramTypes);
+
+	ViewVolume view(world_to_clip, nullptr);
+
+	static std::vector< Object const * > objects;
+	objects.clear();
+	for (Scene::Object *object = first_object; object != nullptr; object = object->alloc_next) {
+		//don't draw if no program of this type attached to object:
+		if (object->programs[program_type].program == nullptr) continue;
+
+		if (!include(*object)) continue;
+
+		if (!view.visible(*object)) {
+			draw_stats.culled += 1;
+			continue;
+		}
+
+		objects.emplace_back(object);
+	}
+
+	draw_objects(objects, world_to_clip, program_type);
+}
+
+void Scene::draw_objects(std::vector< Object const * > const &objects, glm::mat4 const &world_to_clip, Object::ProgramType program_type) const {
+	draw_stats.drawn += uint32_t(objects.size());
+	if (objects.empty()) return;
+
+	//Compute every object's matrices and write them into one block of the uniform ring:
+	UniformRing &ring = object_blocks();
+	GLsizeiptr stride = ring.stride(sizeof(ObjectBlock));
+	static std::vector< uint8_t > blocks;
+	blocks.resize(stride * objects.size());
+	for (uint32_t i = 0; i < objects.size(); ++i) {
+		Object const &object = *objects[i];
+		glm::mat4 local_to_world = object.transform->make_local_to_world();
 
-		//set up program uniforms:
-		Object::ProgramInfo const &info = object->programs[program_type];
-		glUseProgram(info.program);
-		if (info.mvp_mat4 != -1U) {
-			glUniformMatrix4fv(info.mvp_mat4, 1, GL_FALSE, glm::value_ptr(mvp));
+		//NOTE: inverse cancels out transpose unless there is scale involved
+		glm::mat3 itmv = glm::inverse(glm::transpose(glm::mat3(local_to_world)));
+
+		ObjectBlock &block = *reinterpret_cast< ObjectBlock * >(blocks.data() + stride * i);
+		//object space to clip space:
+		block.object_to_clip = world_to_clip * local_to_world;
+		//object space to lighting (world) space, for positions and normals:
+		//(the fourth component of each column is std140 padding, so whole columns can be copied)
+		for (uint32_t c = 0; c < 4; ++c) {
+			block.object_to_light[c] = local_to_world[c];
 		}
-		if (info.mv_mat4x3 != -1U) {
-			glUniformMatrix4x3fv(info.mv_mat4x3, 1, GL_FALSE, glm::value_ptr(mv));
+		for (uint32_t c = 0; c < 3; ++c) {
+			block.normal_to_light[c] = glm::vec4(itmv[c], 0.0f);
 		}
-		if (info.itmv_mat3 != -1U) {
-			glUniformMatrix3fv(info.itmv_mat3, 1, GL_FALSE, glm::value_ptr(itmv));
+		block.glow_amt = object.programs[program_type].glow_amt;
+	}
+	GLintptr base = ring.push(blocks.data(), GLsizeiptr(blocks.size()));
+
+	//Draw, only changing state that differs from the previous object:
+	GLuint current_program = 0;
+	GLuint current_vao = 0;
+	GLuint current_textures[Object::ProgramInfo::TextureCount] = {0,0,0,0};
+	for (uint32_t i = 0; i < objects.size(); ++i) {
+		Object const &object = *objects[i];
+		Object::ProgramInfo const &info = object.programs[program_type];
+
+		if (*info.program != current_program) {
+			glUseProgram(*info.program);
+			current_program = *info.program;
+		}
+
+		if (info.object_block) {
+			glBindBufferRange(GL_UNIFORM_BUFFER, ObjectBinding, ring.buffer, base + stride * i, sizeof(ObjectBlock));
+		} else {
+			ObjectBlock const &block = *reinterpret_cast< ObjectBlock const * >(blocks.data() + stride * i);
+			if (info.mvp_mat4 != -1U) {
+				glUniformMatrix4fv(info.mvp_mat4, 1, GL_FALSE, glm::value_ptr(block.object_to_clip));
+			}
+			if (info.mv_mat4x3 != -1U) {
+				glm::mat4x3 mv = glm::mat4x3(object.transform->make_local_to_world());
+				glUniformMatrix4x3fv(info.mv_mat4x3, 1, GL_FALSE, glm::value_ptr(mv));
+			}
+			if (info.itmv_mat3 != -1U) {
+				glm::mat3 itmv = glm::mat3(glm::vec3(block.normal_to_light[0]), glm::vec3(block.normal_to_light[1]), glm::vec3(block.normal_to_light[2]));
+				glUniformMatrix3fv(info.itmv_mat3, 1, GL_FALSE, glm::value_ptr(itmv));
+			}
 		}
 
 		if (info.set_uniforms) info.set_uniforms();
 
 		//set up program textures:
-		for (uint32_t i = 0; i < Object::ProgramInfo::TextureCount; ++i) {
-			if (info.textures[i] != 0) {
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(GL_TEXTURE_2D, info.textures[i]);
+		for (uint32_t t = 0; t < Object::ProgramInfo::TextureCount; ++t) {
+			if (info.textures[t] != 0 && info.textures[t] != current_textures[t]) {
+				glActiveTexture(GL_TEXTURE0 + t);
+				glBindTexture(GL_TEXTURE_2D, info.textures[t]);
+				current_textures[t] = info.textures[t];
 			}
 		}
 
-		glBindVertexArray(info.vao);
+		if (info.vao != current_vao) {
+			glBindVertexArray(info.vao);
+			current_vao = info.vao;
+		}
 
 		//draw the object:
 		glDrawArrays(GL_TRIANGLES, info.start, info.count);
-
 	}
 
 	//unbind any still bound textures and go back to active texture unit zero:
-	for (uint32_t i = 0; i < Object::ProgramInfo::TextureCount; ++i) {
-		glActiveTexture(GL_TEXTURE0 + i);
+	for (uint32_t t = 0; t < Object::ProgramInfo::TextureCount; ++t) {
+		if (current_textures[t] == 0) continue;
+		glActiveTexture(GL_TEXTURE0 + t);
 		glBindTexture(GL_TEXTURE_2D, 0);
 	}
 	glActiveTexture(GL_TEXTURE0);
@@ -266,14 +569,26 @@ void Scene::draw(glm::mat4 const &world_to_clip, Object::ProgramType program_typ
 
 
 Scene::~Scene() {
+	//(delete_* only unlinks things from the lists, so free each one after)
 	while (first_camera) {
-		delete_camera(first_camera);
+		Camera *c = first_camera;
+		delete_camera(c);
+		delete c;
+	}
+	while (first_lamp) {
+		Lamp *l = first_lamp;
+		delete_lamp(l);
+		delete l;
 	}
 	while (first_object) {
-		delete_object(first_object);
+		Object *o = first_object;
+		delete_object(o);
+		delete o;
 	}
 	while (first_transform) {
-		delete_transform(first_transform);
+		Transform *t = first_transform;
+		delete_transform(t);
+		delete t;
 	}
 }
 
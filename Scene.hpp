@@ -48,6 +48,22 @@ struct Scene {
 		glm::mat4 make_local_to_world() const;
 		glm::mat4 make_world_to_local() const;
 
+		//state at the start of the latest simulation tick, used to draw in between ticks (see Scene::interpolate):
+		struct TickState {
+			bool valid = false; //(false until the first tick, or after a jump -- the transform is then drawn as-is)
+			glm::vec3 position, scale;
+			glm::quat rotation;
+		};
+		TickState tick_state;
+
+		//don't blend from the previous tick (e.g., after teleporting):
+		void skip_interpolation() { tick_state.valid = false; }
+
+		//world-space bounding box of a local-space box (e.g., an attached object's mesh bounds):
+		// the result is cached, and only recomputed when position/rotation/scale or the box change.
+		// (transforms with a parent are never cached, since the parent might have moved)
+		void make_world_bounds(glm::vec3 const &local_min, glm::vec3 const &local_max, glm::vec3 *world_min, glm::vec3 *world_max) const;
+
 		//constructor/destructor:
 		Transform() = default;
 		Transform(Transform &) = delete;
@@ -68,6 +84,16 @@ struct Scene {
 		//used by Scene to manage allocation:
 		Transform **alloc_prev_next = nullptr;
 		Transform *alloc_next = nullptr;
+		mutable uint32_t copy_index = -1U; //position in the list, noted when the scene is copied (see CopyMap)
+
+		//used by make_world_bounds:
+		struct BoundsCache {
+			bool valid = false;
+			glm::vec3 position, scale, local_min, local_max; //inputs the bounds were computed from
+			glm::quat rotation;
+			glm::vec3 world_min, world_max;
+		};
+		mutable BoundsCache bounds_cache;
 	};
 
 	//"Object"s contain information needed to render meshes:
@@ -84,7 +110,7 @@ struct Scene {
 			ProgramTypes //count of program types
 		};
 		struct ProgramInfo {
-			GLuint program = 0;
+			GLuint const *program = nullptr; //(points at the program so that reloaded shaders are picked up; see shader_files.hpp)
 
 			//attributes:
 			GLuint vao = 0;
@@ -92,10 +118,16 @@ struct Scene {
 			GLuint count = 0;
 
 			//uniforms:
+			//if set, the program gets its matrices and material from the "Object" uniform block (see uniform_blocks.hpp):
+			bool object_block = false;
+			//otherwise, they are set individually:
 			GLuint mvp_mat4 = -1U; //uniform index for object-to-clip matrix (mat4)
 			GLuint mv_mat4x3 = -1U; //uniform index for model-to-lighting-space matrix (mat4x3)
 			GLuint itmv_mat3 = -1U; //uniform index for normal-to-lighting-space matrix (mat3)
-			std::function< void() > set_uniforms; //(optional) function to set additional uniforms
+			std::function< void() > set_uniforms; //(optional, slow) function to set additional uniforms
+
+			//material parameters (only for programs that use the "Object" block):
+			float glow_amt = 0.0f; //how much of the surface color goes to the glow (bloom) buffer
 
 			//textures:
 			enum : uint32_t { TextureCount = 4 };
@@ -105,12 +137,28 @@ struct Scene {
 		//used by Scene to manage allocation:
 		Object **alloc_prev_next = nullptr;
 		Object *alloc_next = nullptr;
+		mutable uint32_t copy_index = -1U; //position in the list, noted when the scene is copied (see CopyMap)
 
 		// Which portal it is in
 		Portal *portal_in = nullptr;
 
 		std::string data = "";
         float lifespan = -1.0f;
+
+		//unique (per-scene) identifier, assigned by Scene::new_object; used to match objects across snapshots:
+		uint32_t id = 0;
+
+		//object-space bounding box of the mesh (see MeshBuffer::Mesh):
+		// Scene::draw skips objects whose bounds are out of view; objects with empty bounds (min == max) are always drawn.
+		glm::vec3 mesh_min = glm::vec3(0.0f);
+		glm::vec3 mesh_max = glm::vec3(0.0f);
+
+		//does this object write to the glow (bloom) buffer?
+		bool glows = false;
+
+		//does this object move during play? (foods, portals)
+		// moving objects are drawn into the shadow map every frame; the rest are cached (see GameMode::draw)
+		bool moves = false;
 	};
 
 	//"Lamp"s contain information about lights:
@@ -144,6 +192,7 @@ struct Scene {
 		//used by Scene to manage allocation:
 		Lamp **alloc_prev_next = nullptr;
 		Lamp *alloc_next = nullptr;
+		mutable uint32_t copy_index = -1U; //position in the list, noted when the scene is copied (see CopyMap)
 	};
 
 	//"Camera"s contain information needed to view a scene:
@@ -166,10 +215,12 @@ struct Scene {
 		//used by Scene to manage allocation:
 		Camera **alloc_prev_next = nullptr;
 		Camera *alloc_next = nullptr;
+		mutable uint32_t copy_index = -1U; //position in the list, noted when the scene is copied (see CopyMap)
 	};
 
 	//------ functions to create / destroy scene things -----
 	//NOTE: all scene objects are automatically freed when scene is deallocated
+	// (the delete_* functions only take things out of the scene; whoever calls them must free them)
 
 	//Create a new transform:
 	Transform *new_transform();
@@ -198,6 +249,50 @@ struct Scene {
 	Camera *first_camera = nullptr;
 	//(you shouldn't be manipulating these pointers directly
 
+	//id given to the next object created by new_object:
+	uint32_t next_object_id = 1;
+
+	//objects the draw functions have sent to OpenGL or skipped as out of view (reset by whoever reports them):
+	struct DrawStats {
+		uint32_t drawn = 0;
+		uint32_t culled = 0;
+	};
+	mutable DrawStats draw_stats;
+
+	//------ fixed-step simulation (see Mode::Tick) ------
+
+	//remember every transform's position/rotation/scale; call at the start of each simulation tick:
+	void store_tick_state();
+
+	//for drawing between ticks, set every transform to a blend of its state at the start of the latest tick
+	// (alpha = 0) and its current state (alpha = 1). This loses the current state, so it's meant for copies:
+	void interpolate(float alpha);
+
+	//------ copying (for drawing while the original keeps changing) ------
+
+	//which copy (in this scene) corresponds to each thing in the scene copied from:
+	// copies are listed by position in the copied scene's lists, and copy_from notes each original's
+	// position in its copy_index, so looking one up is an array read.
+	struct CopyMap {
+		std::vector< Transform * > transforms;
+		std::vector< Object * > objects;
+		std::vector< Lamp * > lamps;
+		std::vector< Camera * > cameras;
+
+		//the copy of something in the scene most recently copied:
+		Transform *at(Transform const *t) const { return transforms.at(t->copy_index); }
+		Object *at(Object const *o) const { return objects.at(o->copy_index); }
+		Lamp *at(Lamp const *l) const { return lamps.at(l->copy_index); }
+		Camera *at(Camera const *c) const { return cameras.at(c->copy_index); }
+	};
+
+	//make this scene a copy of 'other' (transforms -- without bounding boxes --, objects, lamps, and cameras, in the same order);
+	// things already in this scene (and the CopyMap's arrays) are reused, so once the scene stops growing, copying
+	// doesn't allocate -- as long as object names ('data') fit in the copies' strings, and objects leave
+	// ProgramInfo::set_uniforms empty (no object in the game sets it; copying one with a large callable would allocate).
+	// Objects' portal_in is cleared, since it points outside the scene.
+	void copy_from(Scene const &other, CopyMap *copies);
+
 	//------ functions to traverse the scene ------
 
 	//Draw the scene from a given camera by computing appropriate matrices and sending all objects to OpenGL:
@@ -209,11 +304,21 @@ struct Scene {
 	void draw(Lamp const *lamp, Object::ProgramType = Object::ProgramTypeDefault ) const;
 
 	//More general draw function. Will render with a specified projection transformation and use programs in the given slot of all objects:
+	// objects outside the view volume of 'world_to_clip' -- or, for portal passes, hidden behind the portal -- are skipped.
 	void draw(
 		glm::mat4 const &world_to_clip,
 		Object::ProgramType program_type, Portal * = nullptr ) const;
 
-	~Scene(); //destructor deallocates transforms, objects, cameras
+	//Draw only the objects for which 'include' returns true (whichever portal they are in, and skipping those out of view):
+	void draw_if(
+		glm::mat4 const &world_to_clip,
+		Object::ProgramType program_type,
+		std::function< bool(Object const &) > const &include ) const;
+
+	//Draw a list of objects (used by the functions above):
+	void draw_objects(std::vector< Object const * > const &objects, glm::mat4 const &world_to_clip, Object::ProgramType program_type) const;
+
+	~Scene(); //destructor deallocates transforms, objects, lamps, cameras
 
 	//add transforms/objects/cameras from a scene file:
 	// the 'on_object' callback gives you a chance to look up a mesh by name and make an object.
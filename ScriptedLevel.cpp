@@ -0,0 +1,631 @@
+#include "ScriptedLevel.hpp"
+#include "BoundingBox.hpp"
+#include "data_path.hpp"
+#include "read_chunk.hpp"
+#include "texture_program.hpp"
+#include "depth_program.hpp"
+#include "shader_files.hpp"
+#include "gl_errors.hpp"
+
+#include "draw_text.hpp"
+#include "draw_overlay.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+Load< MeshBuffer > steak_meshes(LoadTagDefault, [](){
+	return new MeshBuffer(data_path("steakLevels.pnct"));
+});
+
+Load< GLuint > steak_meshes_for_texture_program(LoadTagDefault, [](){
+	return new GLuint(steak_meshes->make_vao_for_program(texture_program->program));
+});
+
+Load< GLuint > steak_meshes_for_depth_program(LoadTagDefault, [](){
+	return new GLuint(steak_meshes->make_vao_for_program(depth_program->program));
+});
+
+//Uniform locations in heat_program:
+GLint heat_program_top_float = -1;
+GLint heat_program_bottom_float = -1;
+GLint heat_program_cam_scale_mat4 = -1;
+GLint heat_program_time_float = -1;
+
+Load< GLuint > heat_program(LoadTagDefault, [](){
+	GLuint *ret = new GLuint(0);
+	//sources: dist/shaders/heat.vert, heat.frag
+	load_program_files(ret, "heat.vert", "heat.frag", [](GLuint program){
+		heat_program_top_float = glGetUniformLocation(program, "top");
+		heat_program_bottom_float = glGetUniformLocation(program, "bottom");
+		heat_program_cam_scale_mat4 = glGetUniformLocation(program, "cam_scale");
+		heat_program_time_float = glGetUniformLocation(program, "time");
+	});
+	return ret;
+});
+
+//1x1 textures of a single color (the steak's cooking stages):
+static GLuint *make_color_tex(glm::u8vec4 const &color) {
+	GLuint tex = 0;
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, glm::value_ptr(color));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return new GLuint(tex);
+}
+
+Load< GLuint > meat1_tex(LoadTagDefault, [](){ return make_color_tex(glm::u8vec4(0xa0, 0xa0, 0xa0, 0xff)); });
+Load< GLuint > meat2_tex(LoadTagDefault, [](){ return make_color_tex(glm::u8vec4(0x40, 0x40, 0x40, 0xff)); });
+Load< GLuint > meat3_tex(LoadTagDefault, [](){ return make_color_tex(glm::u8vec4(0x25, 0x23, 0x23, 0xff)); });
+Load< GLuint > meat4_tex(LoadTagDefault, [](){ return make_color_tex(glm::u8vec4(0x11, 0x05, 0x05, 0xff)); });
+
+//level scripts (and their bgm samples), read the first time a level asks for them and kept
+// (playing samples point at the samples, and the menu and level select reload the same files often):
+static std::mutex scripts_mutex;
+
+static Sound::Sample const *load_bgm(std::string const &name) {
+	static std::map< std::string, std::unique_ptr< Sound::Sample > > loaded; //(guarded by scripts_mutex)
+	auto f = loaded.find(name);
+	if (f == loaded.end()) {
+		f = loaded.insert(std::make_pair(name, std::unique_ptr< Sound::Sample >(new Sound::Sample(data_path(name))))).first;
+	}
+	return f->second.get();
+}
+
+static GLuint texture_named(std::string const &name) {
+	if (name == "white") return *white_tex;
+	if (name == "kitchen") return *kitchen_tex;
+	if (name == "darkkitchen") return *darkkitchen_tex;
+	if (name == "meat1") return *meat1_tex;
+	if (name == "meat2") return *meat2_tex;
+	if (name == "meat3") return *meat3_tex;
+	if (name == "meat4") return *meat4_tex;
+	throw std::runtime_error("Level uses unknown texture '" + name + "'.");
+}
+
+static void use_meshes(std::string const &name, ScriptedLevel::Script *script) {
+	if (name == "vegetables") {
+		script->meshes = &*vegetable_meshes;
+		script->texture_vao = *vegetable_meshes_for_texture_program;
+		script->depth_vao = *vegetable_meshes_for_depth_program;
+	} else if (name == "steakLevels") {
+		script->meshes = &*steak_meshes;
+		script->texture_vao = *steak_meshes_for_texture_program;
+		script->depth_vao = *steak_meshes_for_depth_program;
+	} else {
+		throw std::runtime_error("Level uses unknown mesh file '" + name + "'.");
+	}
+}
+
+std::shared_ptr< ScriptedLevel::Script const > ScriptedLevel::load_script(std::string const &filename) {
+	std::lock_guard< std::mutex > lock(scripts_mutex);
+	static std::map< std::string, std::shared_ptr< Script const > > scripts;
+	auto f = scripts.find(filename);
+	if (f != scripts.end()) return f->second;
+
+	std::shared_ptr< Script > script = std::make_shared< Script >();
+
+	//------ read the level file (see levels/export-level.py for the layout) ------
+
+	std::ifstream file(filename, std::ios::binary);
+
+	std::vector< char > strings;
+	read_chunk(file, "str0", &strings);
+
+	struct StringRef {
+		uint32_t begin, end;
+	};
+	static_assert(sizeof(StringRef) == 4 + 4, "StringRef is packed.");
+	auto string = [&](StringRef const &ref) {
+		if (!(ref.begin <= ref.end && ref.end <= strings.size())) {
+			throw std::runtime_error("Level '" + filename + "' has an out-of-range string reference.");
+		}
+		return std::string(strings.data() + ref.begin, strings.data() + ref.end);
+	};
+
+	struct LevelEntry {
+		StringRef bgm;
+		StringRef prelude;
+		float prelude_time;
+		StringRef meshes;
+		int32_t start_score;
+		uint32_t win_hits;
+		float time_limit;
+		float message_time;
+		glm::vec3 sky_color;
+		glm::vec3 sky_direction;
+	};
+	static_assert(sizeof(LevelEntry) == 8 + 8 + 4 + 8 + 4 + 4 + 4 + 4 + 4*3 + 4*3, "LevelEntry is packed.");
+	std::vector< LevelEntry > level;
+	read_chunk(file, "lvl0", &level);
+	if (level.size() != 1) throw std::runtime_error("Level '" + filename + "' should have exactly one 'lvl0' entry.");
+
+	std::vector< StringRef > kind_names;
+	read_chunk(file, "knd0", &kind_names);
+
+	struct PotEntry {
+		uint32_t kind;
+		glm::vec3 position;
+	};
+	static_assert(sizeof(PotEntry) == 4 + 4*3, "PotEntry is packed.");
+	std::vector< PotEntry > pots;
+	read_chunk(file, "pot0", &pots);
+
+	struct PropEntry {
+		StringRef mesh;
+		StringRef texture;
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+		uint32_t food;
+		glm::vec2 box;
+	};
+	static_assert(sizeof(PropEntry) == 8 + 8 + 4*3 + 4*4 + 4*3 + 4 + 4*2, "PropEntry is packed.");
+	std::vector< PropEntry > props;
+	read_chunk(file, "prp0", &props);
+
+	static_assert(sizeof(SpawnPhase) == 4*5 + 4 + 4, "SpawnPhase is packed.");
+	read_chunk(file, "spn0", &script->spawn_phases);
+	read_chunk(file, "tbl0", &script->spawn_table);
+
+	static_assert(sizeof(Rule) == 4 + 4 + 4, "Rule is packed.");
+	std::vector< Rule > rule_entries;
+	read_chunk(file, "rul0", &rule_entries);
+	if (rule_entries.size() != EventCount) throw std::runtime_error("Level '" + filename + "' should have a 'rul0' entry for each event.");
+
+	static_assert(sizeof(HeatBand) == 4*7, "HeatBand is packed.");
+	std::vector< HeatBand > heat_bands;
+	read_chunk(file, "hot0", &heat_bands);
+	if (heat_bands.size() > 1) throw std::runtime_error("Level '" + filename + "' should have at most one 'hot0' entry.");
+
+	struct StageEntry {
+		float above;
+		StringRef texture;
+	};
+	static_assert(sizeof(StageEntry) == 4 + 8, "StageEntry is packed.");
+	std::vector< StageEntry > stages;
+	read_chunk(file, "stg0", &stages);
+
+	struct MessageEntry {
+		StringRef text;
+		float y;
+		float height;
+	};
+	static_assert(sizeof(MessageEntry) == 8 + 4 + 4, "MessageEntry is packed.");
+	std::vector< MessageEntry > message_entries;
+	read_chunk(file, "msg0", &message_entries);
+
+	if (file.peek() != EOF) {
+		std::cerr << "WARNING: trailing data in level file '" << filename << "'" << std::endl;
+	}
+
+	//------ check, and resolve names to meshes, textures, and samples ------
+
+	use_meshes(string(level[0].meshes), script.get());
+	for (auto const &ref : kind_names) {
+		script->kinds.emplace_back(string(ref));
+		script->kind_meshes.emplace_back(script->meshes->lookup(script->kinds.back())); //(throws if there's no such mesh)
+	}
+	for (uint32_t kind : script->spawn_table) {
+		if (kind >= script->kinds.size()) throw std::runtime_error("Level '" + filename + "' spawns an out-of-range food kind.");
+	}
+	for (auto const &phase : script->spawn_phases) {
+		if (!(phase.table_begin < phase.table_end && phase.table_end <= script->spawn_table.size())) {
+			throw std::runtime_error("Level '" + filename + "' has a spawn phase with an out-of-range food table.");
+		}
+		if (phase.x_count == 0 || !(phase.interval > 0.0f)) {
+			throw std::runtime_error("Level '" + filename + "' has a spawn phase with no positions or no interval.");
+		}
+	}
+	std::copy(rule_entries.begin(), rule_entries.end(), script->rules);
+	script->win_hits = level[0].win_hits;
+	script->time_limit = level[0].time_limit;
+	script->start_score = level[0].start_score;
+	script->message_time = level[0].message_time;
+	script->sky_color = level[0].sky_color;
+	script->sky_direction = level[0].sky_direction;
+	if (!heat_bands.empty()) {
+		script->has_heat_band = true;
+		script->heat_band = heat_bands[0];
+		if (!(script->heat_band.score_interval > 0.0f)) {
+			throw std::runtime_error("Level '" + filename + "' has a heat band with no score interval.");
+		}
+	}
+	for (auto const &entry : stages) {
+		if (!script->heat_stages.empty() && entry.above < script->heat_stages.back().above) {
+			throw std::runtime_error("Level '" + filename + "' has heat stages out of order.");
+		}
+		script->heat_stages.emplace_back();
+		script->heat_stages.back().above = entry.above;
+		script->heat_stages.back().texture = texture_named(string(entry.texture));
+	}
+	for (auto const &entry : message_entries) {
+		script->messages.emplace_back();
+		script->messages.back().text = string(entry.text);
+		script->messages.back().y = entry.y;
+		script->messages.back().height = entry.height;
+	}
+
+	if (!pots.empty()) script->pot_mesh = script->meshes->lookup("Pot");
+	for (auto const &entry : pots) {
+		if (entry.kind >= script->kinds.size()) throw std::runtime_error("Level '" + filename + "' has a pot for an out-of-range food kind.");
+		script->pots.emplace_back();
+		script->pots.back().kind = entry.kind;
+		script->pots.back().position = entry.position;
+	}
+	for (auto const &entry : props) {
+		script->props.emplace_back();
+		Prop &prop = script->props.back();
+		prop.name = string(entry.mesh);
+		prop.mesh = script->meshes->lookup(prop.name);
+		prop.texture = texture_named(string(entry.texture));
+		prop.position = entry.position;
+		prop.rotation = entry.rotation;
+		prop.scale = entry.scale;
+		prop.food = (entry.food != 0);
+		prop.box = entry.box;
+	}
+	if (script->has_heat_band && std::none_of(script->props.begin(), script->props.end(), [](Prop const &prop){ return prop.food; })) {
+		throw std::runtime_error("Level '" + filename + "' has a heat band but no placed food for it to heat.");
+	}
+
+	std::string bgm_name = string(level[0].bgm);
+	if (!bgm_name.empty()) {
+		script->bgm = load_bgm(bgm_name);
+	}
+	std::string prelude_name = string(level[0].prelude);
+	if (!prelude_name.empty()) {
+		if (!(level[0].prelude_time > 0.0f)) throw std::runtime_error("Level '" + filename + "' has a prelude with no length.");
+		script->prelude = load_bgm(prelude_name);
+		script->prelude_time = level[0].prelude_time;
+	}
+
+	scripts.insert(std::make_pair(filename, script));
+	return script;
+}
+
+ScriptedLevel::ScriptedLevel(GameMode *gm, Scene::Object::ProgramInfo const &texture_program_info,
+                            Scene::Object::ProgramInfo const &depth_program_info,
+                            std::string const &filename) : Level(gm), script(load_script(filename)) {
+
+	this->texture_program_info = texture_program_info;
+	this->texture_program_info.vao = script->texture_vao;
+	this->depth_program_info = depth_program_info;
+	this->depth_program_info.vao = script->depth_vao;
+
+	sky_color = script->sky_color;
+	sky_direction = script->sky_direction;
+
+	for (auto const &pot : script->pots) {
+		Scene::Object *obj = create_object(script->pot_mesh);
+		obj->transform->position = pot.position;
+		obj->transform->boundingbox = new BoundingBox(2.0f, 2.0f);
+		obj->transform->boundingbox->update_origin(obj->transform->position, glm::vec2(0.0f, 1.0f));
+		obj->data = script->kinds[pot.kind];
+		gm->pots.push_back(obj);
+	}
+
+	for (auto const &prop : script->props) {
+		Scene::Object *obj = create_object(prop.mesh);
+		obj->programs[Scene::Object::ProgramTypeDefault].textures[0] = prop.texture;
+		obj->transform->position = prop.position;
+		obj->transform->rotation = prop.rotation;
+		obj->transform->scale = prop.scale;
+		if (prop.food) {
+			obj->transform->boundingbox = new BoundingBox(prop.box.x, prop.box.y);
+			obj->transform->boundingbox->update_origin(obj->transform->position, glm::vec2(0.0f, 1.0f));
+			obj->data = prop.name;
+			obj->moves = true;
+			gm->foods.push_back(obj);
+			if (!heated) {
+				heated = obj;
+				raw_texture = prop.texture;
+			}
+		}
+	}
+
+	if (gm->level < gm->scores.size()) { //(not for the menu's background level)
+		gm->scores[gm->level] = uint32_t(std::max(0, script->start_score));
+	}
+	messagetime = script->message_time;
+	score_timer = script->heat_band.score_interval;
+
+	if (script->prelude) {
+		prelude = script->prelude->play(gm->camera->transform->position, 1.0f);
+		prelude_countdown = script->prelude_time;
+	} else if (script->bgm) {
+		bgm = script->bgm->play(gm->camera->transform->position, 1.0f, Sound::Loop);  // play bgm
+	}
+}
+
+Scene::Object *ScriptedLevel::create_object(MeshBuffer::Mesh const &mesh) {
+	Scene::Object *obj = gm->scene->new_object(gm->scene->new_transform());
+	obj->programs[Scene::Object::ProgramTypeDefault] = texture_program_info;
+	obj->programs[Scene::Object::ProgramTypeDefault].textures[0] = *white_tex;
+
+	obj->programs[Scene::Object::ProgramTypeShadow] = depth_program_info;
+
+	obj->mesh_min = mesh.min;
+	obj->mesh_max = mesh.max;
+	obj->programs[Scene::Object::ProgramTypeDefault].start = mesh.start;
+	obj->programs[Scene::Object::ProgramTypeDefault].count = mesh.count;
+
+	obj->programs[Scene::Object::ProgramTypeShadow].start = mesh.start;
+	obj->programs[Scene::Object::ProgramTypeShadow].count = mesh.count;
+	obj->transform->rotation = glm::angleAxis(glm::radians(-90.f), glm::vec3(1.f,0.f,0.f));
+
+	return obj;
+}
+
+Scene::Object *ScriptedLevel::add_food(std::string const &data) {
+	auto f = std::find(script->kinds.begin(), script->kinds.end(), data);
+	Scene::Object *obj = create_object(f != script->kinds.end()
+		? script->kind_meshes[f - script->kinds.begin()]
+		: script->meshes->lookup(data)); //(not one of this level's kinds; throws if there's no such mesh)
+	obj->transform->boundingbox = new BoundingBox(2.0f, 2.0f);
+	obj->data = data;
+	obj->moves = true;
+	gm->foods.push_back(obj);
+	return obj;
+}
+
+void ScriptedLevel::add_foods(std::vector< std::string > const &datas, std::vector< Scene::Object * > *made) {
+	//(a kind's mesh is looked up only when the kind changes from the food before)
+	std::string const *kind = nullptr;
+	MeshBuffer::Mesh const *mesh = nullptr;
+	made->reserve(made->size() + datas.size());
+	for (auto const &data : datas) {
+		if (!kind || data != *kind) {
+			auto f = std::find(script->kinds.begin(), script->kinds.end(), data);
+			mesh = &(f != script->kinds.end()
+				? script->kind_meshes[f - script->kinds.begin()]
+				: script->meshes->lookup(data)); //(as in add_food)
+			kind = &data;
+		}
+		Scene::Object *obj = create_object(*mesh);
+		obj->transform->boundingbox = new BoundingBox(2.0f, 2.0f);
+		obj->data = data;
+		obj->moves = true;
+		gm->foods.push_back(obj);
+		made->push_back(obj);
+	}
+}
+
+void ScriptedLevel::spawn_food() {
+	SpawnPhase const &p = script->spawn_phases[phase];
+	uint32_t kind = script->spawn_table[p.table_begin + gm->random.spawn.below(p.table_end - p.table_begin)];
+	Scene::Object *obj = add_food(script->kinds[kind]);
+	obj->transform->position = glm::vec3(p.x_min + float(gm->random.spawn.below(p.x_count)), p.y, 0.f);
+	obj->transform->boundingbox->update_origin(obj->transform->position, glm::vec2(0.0f, 1.0f));
+}
+
+void ScriptedLevel::heat_band_at(float at, float *top, float *bottom) const {
+	HeatBand const &band = script->heat_band;
+	*top = std::sin(at * band.frequency) * band.amplitude + band.center;
+	*bottom = *top - band.height;
+}
+
+void ScriptedLevel::update_heat(float elapsed) {
+	if (!heated) return;
+
+	//the food cooks through the heat stages:
+	GLuint texture = raw_texture;
+	for (auto const &stage : script->heat_stages) {
+		if (heat > stage.above) texture = stage.texture;
+	}
+	heated->programs[Scene::Object::ProgramTypeDefault].textures[0] = texture;
+
+	float top, bottom;
+	heat_band_at(time, &top, &bottom);
+	glm::vec3 const &at = heated->transform->position;
+	if (at.y > top || at.y < bottom) {
+		heat += script->heat_band.rate * elapsed;
+		if (heat > script->heat_band.max) {
+			gm->show_lose();
+		}
+
+		// steam off the food, thicker as it cooks
+		steam_due += (15.f + 0.6f * heat) * elapsed;
+		ParticleSystem::Particle puff;
+		puff.position = at + glm::vec3(0.f, 2.f, 8.f);
+		puff.velocity = glm::vec3(0.f, 4.f, 0.f);
+		puff.gravity = 6.f; // (rises)
+		puff.drag = 0.8f;
+		puff.life = 1.4f;
+		puff.size = 0.8f;
+		puff.growth = 1.2f;
+		float grey = glm::mix(0.9f, 0.35f, heat / script->heat_band.max); // smoke once it starts to burn
+		puff.color = glm::vec4(grey, grey, grey, 0.35f);
+		uint32_t count = uint32_t(steam_due);
+		steam_due -= float(count);
+		gm->particles.emit_burst(count, puff, glm::vec3(3.f, 1.f, 0.f), glm::vec3(2.f, 1.5f, 0.f));
+	} else {
+		score_timer -= elapsed;
+		if (score_timer < 0.f) {
+			score_timer += script->heat_band.score_interval;
+			apply(InBand);
+		}
+	}
+}
+
+void ScriptedLevel::update(float elapsed) {
+	if (script->has_heat_band) update_heat(elapsed); //(against the band as it was drawn, before 'time' moves on)
+
+	time += elapsed;
+	messagetime -= elapsed;
+
+	if (prelude_countdown > 0.0f) {
+		prelude_countdown -= elapsed;
+		if (prelude_countdown <= 0.0f && script->bgm) {
+			bgm = script->bgm->play(gm->camera->transform->position, 1.0f, Sound::Loop);  // play bgm
+		}
+	}
+
+	if (script->time_limit > 0.0f && time >= script->time_limit) {
+		gm->show_win();
+	}
+
+	if (script->spawn_phases.empty()) return;
+	while (phase + 1 < script->spawn_phases.size() && time >= script->spawn_phases[phase + 1].start) {
+		phase += 1;
+	}
+	if (time < script->spawn_phases[phase].start) return;
+
+	spawn_timer -= elapsed;
+	if (spawn_timer < 0.f) {
+		spawn_timer += script->spawn_phases[phase].interval;
+		spawn_food();
+	}
+}
+
+void ScriptedLevel::apply(Event event) {
+	if (gm->level >= gm->scores.size()) return; //(the menu's background level doesn't keep score)
+	Rule const &rule = script->rules[event];
+	uint32_t &score = gm->scores[gm->level];
+	score = uint32_t(std::max< int64_t >(0, int64_t(score) + rule.score));
+	hits += rule.hits;
+
+	if (rule.loses) {
+		gm->show_lose();
+	} else if (script->win_hits != 0 && rule.hits != 0 && hits >= script->win_hits) {
+		gm->show_win();
+	} else if (rule.score < 0 && score == 0) {
+		gm->show_lose();
+	}
+}
+
+bool ScriptedLevel::collision(Scene::Object *o1, Scene::Object *o2) {
+	{ // splash out of the pot
+		ParticleSystem::Particle drop;
+		drop.position = glm::vec3(o1->transform->position.x, o2->transform->position.y + 3.f, 10.f);
+		drop.velocity = glm::vec3(0.f, 18.f, 0.f);
+		drop.gravity = -45.f;
+		drop.life = 0.8f;
+		drop.size = 0.6f;
+		drop.growth = -0.4f;
+		drop.color = glm::vec4(0.75f, 0.88f, 1.0f, 0.9f);
+		gm->particles.emit_burst(40, drop, glm::vec3(2.f, 0.5f, 0.f), glm::vec3(9.f, 8.f, 0.f));
+	}
+
+	if (o1 == heated) heated = nullptr; //(GameMode deletes foods that land in pots)
+	apply(o1->data == o2->data ? PotMatch : PotMismatch);
+	return true;
+}
+
+void ScriptedLevel::fall_off(Scene::Object *o) {
+	if (o == heated) heated = nullptr; //(...and those that fall off)
+	apply(FallOff);
+}
+
+void ScriptedLevel::capture_draw_state() {
+	drawn.messagetime = messagetime;
+	drawn.time = time;
+	drawn.heat = heat;
+	if (script->has_heat_band) heat_band_at(time, &drawn.top, &drawn.bottom);
+}
+
+void ScriptedLevel::render_pass() {
+	if (!script->has_heat_band) return;
+
+	//the too-hot areas above and below the band:
+	glUseProgram(*heat_program);
+	glBindVertexArray(*empty_vao);
+
+	glDisable(GL_DEPTH_TEST);
+
+	glm::mat4 cam_scale = gm->drawn.camera->make_projection() * gm->drawn.camera->transform->make_world_to_local();
+
+	glUniform1f(heat_program_top_float, drawn.top);
+	glUniform1f(heat_program_bottom_float, drawn.bottom);
+	glUniform1f(heat_program_time_float, script->time_limit - drawn.time); //(the shimmer runs on the time left)
+	glUniformMatrix4fv(heat_program_cam_scale_mat4, 1, GL_FALSE, glm::value_ptr(cam_scale));
+
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	glEnable(GL_DEPTH_TEST);
+
+	GL_ERRORS();
+}
+
+void ScriptedLevel::render_overlay() {
+
+	glDisable(GL_DEPTH_TEST);
+
+	if (script->has_heat_band) { // heat meter (fills up as the food cooks; lose when it's full)
+		static std::vector< OverlayVertex > meter; //(static to avoid re-allocating every frame)
+		meter.clear();
+		float amt = std::min(std::max(drawn.heat / script->heat_band.max, 0.0f), 1.0f);
+		glm::vec2 min = glm::vec2(-1.5f, -0.6f);
+		glm::vec2 max = glm::vec2(-1.42f, 0.6f);
+		add_overlay_rect(&meter, min - glm::vec2(0.01f), max + glm::vec2(0.01f), glm::u8vec4(0x00, 0x00, 0x00, 0xa0));
+		add_overlay_rect(&meter, min, glm::vec2(max.x, glm::mix(min.y, max.y, amt)),
+			glm::u8vec4(0xff, uint8_t(0xe0 * (1.0f - amt)), 0x00, 0xff)); //yellow to red
+		draw_overlay(meter);
+
+		float height = 0.05f;
+		draw_text("HEAT", glm::vec2(0.5f * (min.x + max.x) - 0.5f * text_width("HEAT", height), max.y + 0.03f), height);
+	}
+
+	if (drawn.messagetime > 0.f) {
+		for (auto const &message : script->messages) {
+			float width = text_width(message.text, message.height);
+			draw_text(message.text, glm::vec2( -width/2.f, message.y), message.height,
+				glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+		}
+	}
+
+	glEnable(GL_DEPTH_TEST);
+
+	GL_ERRORS();
+}
+
+struct ScriptedLevelState {
+	uint32_t hits;
+	float time;
+	float spawn_timer;
+	uint32_t phase;
+	float messagetime;
+	float heat;
+	float score_timer;
+	float steam_due;
+	float prelude_countdown;
+};
+
+void ScriptedLevel::save_state(std::vector< uint8_t > *out) const {
+	save_pod(out, ScriptedLevelState{hits, time, spawn_timer, phase, messagetime, heat, score_timer, steam_due, prelude_countdown});
+}
+
+bool ScriptedLevel::restore_state(uint8_t const *data, size_t size) {
+	ScriptedLevelState state;
+	if (!restore_pod(data, size, &state)) return false;
+	if (!script->spawn_phases.empty() && state.phase >= script->spawn_phases.size()) return false;
+	hits = state.hits;
+	time = state.time;
+	spawn_timer = state.spawn_timer;
+	phase = state.phase;
+	messagetime = state.messagetime;
+	heat = state.heat;
+	score_timer = state.score_timer;
+	steam_due = state.steam_due;
+	prelude_countdown = state.prelude_countdown;
+	if (prelude && prelude_countdown <= 0.0f) {
+		// past the prelude already; go straight to the bgm
+		prelude->stop();
+		prelude.reset();
+		if (script->bgm) bgm = script->bgm->play(gm->camera->transform->position, 1.0f, Sound::Loop);
+	}
+	return true;
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Level.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+//ScriptedLevel plays a level described by a ".level" file (made by levels/export-level.py from a
+// python description like levels/vegetables.py or levels/oven.py): scenery, foods placed at the start,
+// pots and the food each one accepts, spawn phases with weighted food tables, an optional heat band,
+// score/hit rules, and an intro message.
+//The file's chunks are read straight into the flat tables of a Script, so each tick is a few
+// lookups (e.g., spawning is one draw into 'spawn_table' and one for the x position).
+//
+//The rules: a food landing in the pot that accepts it is a "pot match", in any other pot a
+// "pot mismatch", and off the bottom a "fall off"; each applies its rule's score change (the
+// score stops at zero) and hit count, and loses the level if the rule says so. Reaching 'win_hits'
+// hits wins, as does lasting 'time_limit' seconds; a penalty that leaves the score at zero loses.
+//
+//The heat band (the oven) is a band of safe height that sways up and down; the first placed food
+// heats up whenever it is outside the band -- too much heat loses -- and every 'score_interval'
+// it spends inside is an "in band" event. The food's texture follows its heat through 'heat_stages'.
+struct ScriptedLevel : public Level {
+	ScriptedLevel(GameMode *gm,
+		Scene::Object::ProgramInfo const &texture_program_info,
+		Scene::Object::ProgramInfo const &depth_program_info,
+		std::string const &filename);
+	virtual ~ScriptedLevel() {}
+
+	Scene::Object::ProgramInfo texture_program_info;
+	Scene::Object::ProgramInfo depth_program_info;
+
+	virtual void update(float elapsed) override;
+	virtual bool collision(Scene::Object *o1, Scene::Object *o2) override;
+	virtual void fall_off(Scene::Object *o) override;
+	virtual void render_pass() override;
+	virtual void render_overlay() override;
+	virtual void capture_draw_state() override;
+	virtual void save_state(std::vector< uint8_t > *out) const override;
+	virtual bool restore_state(uint8_t const *data, size_t size) override;
+	virtual Scene::Object *add_food(std::string const &data) override;
+	virtual void add_foods(std::vector< std::string > const &datas, std::vector< Scene::Object * > *made) override;
+	virtual void fade_out(float ramp) override {
+		if (prelude) prelude->stop(ramp);
+		prelude.reset();
+		Level::fade_out(ramp);
+	}
+
+	void spawn_food();
+
+	//------ from the level file ------
+	struct SpawnPhase {
+		float start = 0.0f; //seconds after the level starts
+		float interval = 1.0f; //seconds between foods
+		float x_min = 0.0f; //foods appear at x_min + [0, x_count), at height y
+		uint32_t x_count = 1;
+		float y = 0.0f;
+		uint32_t table_begin = 0, table_end = 0; //range of spawn_table to pick kinds from
+	};
+	enum Event : uint32_t {
+		PotMatch = 0,
+		PotMismatch = 1,
+		FallOff = 2,
+		InBand = 3,
+		EventCount
+	};
+	struct Rule {
+		int32_t score = 0;
+		uint32_t hits = 0;
+		uint32_t loses = 0; //(nonzero: the level is lost)
+	};
+	struct Message {
+		std::string text;
+		float y = 0.0f;
+		float height = 0.1f;
+	};
+	struct Pot {
+		uint32_t kind = 0;
+		glm::vec3 position = glm::vec3(0.0f);
+	};
+	struct Prop {
+		std::string name; //mesh name (and, for placed foods, their Object::data)
+		MeshBuffer::Mesh mesh;
+		GLuint texture = 0;
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 scale = glm::vec3(1.0f);
+		bool food = false; //placed foods move and can fall (the oven's steak)
+		glm::vec2 box = glm::vec2(2.0f); //bounding box width, thickness (foods only)
+	};
+	struct HeatBand {
+		//the band is [top - height, top], with top = center + amplitude * sin(frequency * time):
+		float center = 0.0f, amplitude = 0.0f, frequency = 0.0f, height = 0.0f;
+		float rate = 0.0f; //heat gained per second outside the band
+		float max = 100.0f; //more than this loses
+		float score_interval = 1.0f; //seconds inside the band per "in band" event
+	};
+	struct HeatStage {
+		float above = 0.0f; //the food takes 'texture' once its heat is more than this
+		GLuint texture = 0;
+	};
+	//everything read from a level file, with names already resolved to meshes, textures, and samples
+	// (shared by every ScriptedLevel playing that file):
+	struct Script {
+		MeshBuffer const *meshes = nullptr; //where every mesh below comes from...
+		GLuint texture_vao = 0, depth_vao = 0; //...and its vertex arrays for texture_program and depth_program
+		std::vector< std::string > kinds; //food kinds (mesh name, and the Object::data that pots compare)
+		std::vector< MeshBuffer::Mesh > kind_meshes;
+		std::vector< SpawnPhase > spawn_phases; //sorted by start
+		std::vector< uint32_t > spawn_table; //kind indices, each repeated by its weight
+		Rule rules[EventCount];
+		uint32_t win_hits = 0; //(0 for levels that can't be won by hits)
+		float time_limit = 0.0f; //seconds to last to win (0 for none)
+		int32_t start_score = 0;
+		bool has_heat_band = false;
+		HeatBand heat_band;
+		std::vector< HeatStage > heat_stages; //sorted by 'above'
+		glm::vec3 sky_color = glm::vec3(0.8f);
+		glm::vec3 sky_direction = glm::vec3(0.0f, 0.0f, 1.0f);
+		std::vector< Message > messages;
+		float message_time = 0.0f;
+		std::vector< Pot > pots;
+		MeshBuffer::Mesh pot_mesh;
+		std::vector< Prop > props;
+		Sound::Sample const *bgm = nullptr;
+		Sound::Sample const *prelude = nullptr; //played once at the start; the bgm follows after 'prelude_time'
+		float prelude_time = 0.0f;
+	};
+	std::shared_ptr< Script const > script;
+
+	//read (and check) a level file and load its bgm -- or return the Script read from it earlier:
+	// (safe to call from any thread once assets are loaded; GameMode prewarms levels in the background)
+	static std::shared_ptr< Script const > load_script(std::string const &filename);
+
+	//------ play state (kept by quicksaves) ------
+	uint32_t hits = 0;
+	float time = 0.0f; //since the level started
+	float spawn_timer = 0.0f; //next food when this goes below zero
+	uint32_t phase = 0; //index into script->spawn_phases
+	float messagetime = 0.0f;
+	float heat = 0.0f;
+	float score_timer = 0.0f; //next "in band" event when this goes below zero
+	float steam_due = 0.0f; //steam particles owed (the fractional part carries over between ticks)
+	float prelude_countdown = 0.0f; //bgm starts when this reaches zero
+
+	Scene::Object *heated = nullptr; //the food the heat band watches (the first placed food, while it's around)
+	GLuint raw_texture = 0; //(its texture before it reaches the first heat stage)
+	std::shared_ptr< Sound::PlayingSample > prelude;
+
+	struct {
+		float messagetime = 0.f;
+		float time = 0.f;
+		float heat = 0.f;
+		float top = 0.f, bottom = 0.f;
+	} drawn; //(copied for render_pass/render_overlay)
+
+private:
+	Scene::Object *create_object(MeshBuffer::Mesh const &mesh);
+	void apply(Event event);
+	void update_heat(float elapsed);
+	void heat_band_at(float at, float *top, float *bottom) const;
+};
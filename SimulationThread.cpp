@@ -0,0 +1,66 @@
+#include "SimulationThread.hpp"
+
+SimulationThread::SimulationThread(bool threaded_) : threaded(threaded_) {
+	if (threaded) {
+		worker = std::thread(&SimulationThread::worker_main, this);
+	}
+}
+
+SimulationThread::~SimulationThread() {
+	if (!threaded) return;
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	worker.join();
+}
+
+void SimulationThread::worker_main() {
+	std::unique_lock< std::mutex > lock(mutex);
+	while (true) {
+		wake.wait(lock, [this](){ return quit || running; });
+		if (quit) break;
+
+		std::function< void() > fn;
+		std::swap(fn, job);
+		lock.unlock();
+
+		std::exception_ptr caught;
+		try {
+			fn();
+		} catch (...) {
+			caught = std::current_exception();
+		}
+
+		lock.lock();
+		error = caught;
+		running = false;
+		done.notify_all();
+	}
+}
+
+void SimulationThread::start(std::function< void() > const &job_) {
+	if (!threaded) {
+		job_();
+		return;
+	}
+	finish();
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		job = job_;
+		running = true;
+	}
+	wake.notify_all();
+}
+
+void SimulationThread::finish() {
+	if (!threaded) return;
+	std::exception_ptr caught;
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		done.wait(lock, [this](){ return !running; });
+		std::swap(caught, error);
+	}
+	if (caught) std::rethrow_exception(caught);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+//SimulationThread runs one job at a time on a worker thread, so the main thread can draw meanwhile
+// (main.cpp uses it to run the next frame's updates while the current frame is drawn).
+//If made with threaded == false, start() just runs the job right away.
+struct SimulationThread {
+	SimulationThread(bool threaded);
+	~SimulationThread();
+
+	//begin running 'job' (waits for any job already running to finish first):
+	void start(std::function< void() > const &job);
+
+	//wait for the running job (if any) to finish; rethrows anything it threw:
+	void finish();
+
+	bool threaded = false;
+
+	//internals:
+	void worker_main();
+
+	std::thread worker;
+	std::mutex mutex; //protects everything below
+	std::condition_variable wake; //signalled when a job is posted or on shutdown
+	std::condition_variable done; //signalled when a job finishes
+	bool quit = false;
+	bool running = false;
+	std::function< void() > job;
+	std::exception_ptr error; //thrown by the last job
+};
@@ -0,0 +1,324 @@
+#include "Snapshot.hpp"
+
+#include "GameMode.hpp"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cassert>
+#include <string>
+
+//quantization ranges (play area plus a margin for things that bounce off the edges):
+static constexpr float MinX = -80.0f;
+static constexpr float MaxX = 80.0f;
+static constexpr float MinY = -70.0f;
+static constexpr float MaxY = 60.0f;
+static constexpr float MaxSpeed = 256.0f;
+
+//bits used by each quantized field:
+static constexpr uint32_t PositionBits = 16;
+static constexpr uint32_t SpeedBits = 16;
+static constexpr uint32_t AngleBits = 12;
+
+static uint16_t quantize(float v, float min, float max, uint32_t bits) {
+	float amt = (std::min(std::max(v, min), max) - min) / (max - min);
+	return uint16_t(std::round(amt * float((1U << bits) - 1)));
+}
+
+static float dequantize(uint16_t q, float min, float max, uint32_t bits) {
+	return min + (max - min) * (float(q) / float((1U << bits) - 1));
+}
+
+uint16_t Snapshot::quantize_x(float x) { return quantize(x, MinX, MaxX, PositionBits); }
+uint16_t Snapshot::quantize_y(float y) { return quantize(y, MinY, MaxY, PositionBits); }
+uint16_t Snapshot::quantize_speed(float s) { return quantize(s, -MaxSpeed, MaxSpeed, SpeedBits); }
+uint16_t Snapshot::quantize_angle(float a) {
+	float amt = a / (2.0f * float(M_PI));
+	amt -= std::floor(amt);
+	return uint16_t(uint32_t(std::round(amt * float(1U << AngleBits))) & ((1U << AngleBits) - 1));
+}
+
+float Snapshot::dequantize_x(uint16_t q) { return dequantize(q, MinX, MaxX, PositionBits); }
+float Snapshot::dequantize_y(uint16_t q) { return dequantize(q, MinY, MaxY, PositionBits); }
+float Snapshot::dequantize_speed(uint16_t q) { return dequantize(q, -MaxSpeed, MaxSpeed, SpeedBits); }
+float Snapshot::dequantize_angle(uint16_t q) {
+	float a = float(q) / float(1U << AngleBits) * 2.0f * float(M_PI);
+	return (a > float(M_PI) ? a - 2.0f * float(M_PI) : a);
+}
+
+Snapshot Snapshot::capture(GameMode const &gm, uint32_t tick) {
+	Snapshot ret;
+	ret.tick = tick;
+
+	ret.foods.reserve(gm.foods.size());
+	for (Scene::Object const *obj : gm.foods) {
+		Scene::Transform const *transform = obj->transform;
+		Food food;
+		food.id = obj->id;
+		food.x = quantize_x(transform->position.x);
+		food.y = quantize_y(transform->position.y);
+		food.speed_x = quantize_speed(transform->speed.x);
+		food.speed_y = quantize_speed(transform->speed.y);
+		//gameplay only ever rotates around z, so track where the local x axis ends up:
+		glm::vec3 right = transform->rotation * glm::vec3(1.0f, 0.0f, 0.0f);
+		food.angle = quantize_angle(std::atan2(right.y, right.x));
+		ret.foods.emplace_back(food);
+	}
+	std::sort(ret.foods.begin(), ret.foods.end(), [](Food const &a, Food const &b) {
+		return a.id < b.id;
+	});
+
+	for (uint32_t i = 0; i < 2; ++i) {
+		::Portal const &player = gm.players[i];
+		Portal &portal = ret.portals[i];
+		portal.x = quantize_x(player.position.x);
+		portal.y = quantize_y(player.position.y);
+		portal.speed_x = quantize_speed(player.speed.x);
+		portal.speed_y = quantize_speed(player.speed.y);
+		portal.angle = quantize_angle(std::atan2(player.normal.y, player.normal.x));
+	}
+
+	return ret;
+}
+
+//------------------------------------------
+//bit-level reading and writing:
+
+namespace {
+
+struct BitWriter {
+	BitWriter(std::vector< uint8_t > *out_) : out(*out_) { }
+	~BitWriter() { flush(); }
+
+	void write(uint32_t value, uint32_t bits) {
+		assert(bits <= 32);
+		assert(bits == 32 || value < (1ULL << bits));
+		buffer |= uint64_t(value) << used;
+		used += bits;
+		while (used >= 8) {
+			out.emplace_back(uint8_t(buffer & 0xff));
+			buffer >>= 8;
+			used -= 8;
+		}
+	}
+	void flush() {
+		if (used > 0) {
+			out.emplace_back(uint8_t(buffer & 0xff));
+			buffer = 0;
+			used = 0;
+		}
+	}
+
+	//small values get short codes:
+	//  0 -> '0', <16 -> '10' + 4 bits, <256 -> '110' + 8 bits, otherwise '111' + 'bits' bits
+	void write_small(uint32_t value, uint32_t bits) {
+		if (value == 0) {
+			write(0x0, 1);
+		} else if (value < 16) {
+			write(0x1, 2);
+			write(value, 4);
+		} else if (value < 256) {
+			write(0x3, 3);
+			write(value, 8);
+		} else {
+			write(0x7, 3);
+			write(value, bits);
+		}
+	}
+
+	std::vector< uint8_t > &out;
+	uint64_t buffer = 0;
+	uint32_t used = 0;
+};
+
+struct BitReader {
+	BitReader(uint8_t const *data_, size_t size_) : data(data_), size(size_) { }
+
+	uint32_t read(uint32_t bits) {
+		assert(bits <= 32);
+		while (used < bits) {
+			if (at >= size) {
+				throw std::runtime_error("Snapshot data is truncated.");
+			}
+			buffer |= uint64_t(data[at]) << used;
+			at += 1;
+			used += 8;
+		}
+		uint32_t value = uint32_t(buffer & ((1ULL << bits) - 1));
+		buffer >>= bits;
+		used -= bits;
+		return value;
+	}
+
+	uint32_t read_small(uint32_t bits) {
+		if (read(1) == 0) return 0;
+		if (read(1) == 0) return read(4);
+		if (read(1) == 0) return read(8);
+		return read(bits);
+	}
+
+	uint8_t const *data;
+	size_t size;
+	size_t at = 0;
+	uint64_t buffer = 0;
+	uint32_t used = 0;
+};
+
+//deltas are stored as zig-zag encoded (small magnitude -> small code) values:
+uint32_t zigzag(int32_t d) { return (uint32_t(d) << 1) ^ uint32_t(d >> 31); }
+int32_t unzigzag(uint32_t z) { return int32_t(z >> 1) ^ -int32_t(z & 1); }
+
+void write_field(BitWriter &bits, uint16_t base, uint16_t value, uint32_t field_bits) {
+	bits.write_small(zigzag(int32_t(value) - int32_t(base)), field_bits + 1);
+}
+uint16_t read_field(BitReader &bits, uint16_t base, uint32_t field_bits) {
+	return uint16_t(int32_t(base) + unzigzag(bits.read_small(field_bits + 1)));
+}
+
+//angles wrap, so deltas are taken modulo the angle range:
+void write_angle(BitWriter &bits, uint16_t base, uint16_t value) {
+	int32_t d = (int32_t(value) - int32_t(base)) & ((1 << AngleBits) - 1);
+	if (d >= (1 << (AngleBits - 1))) d -= (1 << AngleBits);
+	bits.write_small(zigzag(d), AngleBits);
+}
+uint16_t read_angle(BitReader &bits, uint16_t base) {
+	return uint16_t((int32_t(base) + unzigzag(bits.read_small(AngleBits))) & ((1 << AngleBits) - 1));
+}
+
+template< typename T >
+bool same_state(T const &a, T const &b) {
+	return a.x == b.x && a.y == b.y && a.speed_x == b.speed_x && a.speed_y == b.speed_y && a.angle == b.angle;
+}
+
+template< typename T >
+void write_state(BitWriter &bits, T const &base, T const &value) {
+	write_field(bits, base.x, value.x, PositionBits);
+	write_field(bits, base.y, value.y, PositionBits);
+	write_field(bits, base.speed_x, value.speed_x, SpeedBits);
+	write_field(bits, base.speed_y, value.speed_y, SpeedBits);
+	write_angle(bits, base.angle, value.angle);
+}
+
+template< typename T >
+void read_state(BitReader &bits, T const &base, T *value) {
+	value->x = read_field(bits, base.x, PositionBits);
+	value->y = read_field(bits, base.y, PositionBits);
+	value->speed_x = read_field(bits, base.speed_x, SpeedBits);
+	value->speed_y = read_field(bits, base.speed_y, SpeedBits);
+	value->angle = read_angle(bits, base.angle);
+}
+
+} //end of anonymous namespace
+
+//------------------------------------------
+//Encoded layout (all bit-packed):
+// tick (32), has_baseline (1), [baseline tick (32)]
+// per portal: changed (1), [state]
+// food count, then per food (in id order):
+//   id gap from previous food, then
+//   if food is in baseline: changed (1), [state relative to baseline]
+//   otherwise: state relative to zero
+
+void encode_snapshot(Snapshot const *baseline, Snapshot const &snapshot, std::vector< uint8_t > *out) {
+	assert(out);
+	BitWriter bits(out);
+
+	bits.write(snapshot.tick, 32);
+	bits.write(baseline ? 1 : 0, 1);
+	if (baseline) bits.write(baseline->tick, 32);
+
+	static Snapshot::Portal const zero_portal;
+	for (uint32_t i = 0; i < 2; ++i) {
+		Snapshot::Portal const &base = (baseline ? baseline->portals[i] : zero_portal);
+		if (same_state(base, snapshot.portals[i])) {
+			bits.write(0, 1);
+		} else {
+			bits.write(1, 1);
+			write_state(bits, base, snapshot.portals[i]);
+		}
+	}
+
+	bits.write_small(uint32_t(snapshot.foods.size()), 32);
+
+	static Snapshot::Food const zero_food;
+	//(baseline foods still to match, as a pointer range -- empty, with both ends null, without a baseline)
+	Snapshot::Food const *base_food = (baseline ? baseline->foods.data() : nullptr);
+	Snapshot::Food const *base_end = (baseline ? baseline->foods.data() + baseline->foods.size() : nullptr);
+	uint32_t prev_id = 0;
+	for (auto const &food : snapshot.foods) {
+		assert(food.id > prev_id && "foods should be sorted by (unique, non-zero) id");
+		bits.write_small(food.id - prev_id - 1, 32);
+		prev_id = food.id;
+
+		while (base_food != base_end && base_food->id < food.id) ++base_food;
+		if (base_food != base_end && base_food->id == food.id) {
+			if (same_state(*base_food, food)) {
+				bits.write(0, 1);
+			} else {
+				bits.write(1, 1);
+				write_state(bits, *base_food, food);
+			}
+		} else {
+			write_state(bits, zero_food, food);
+		}
+	}
+}
+
+Snapshot decode_snapshot(Snapshot const *baseline, uint8_t const *data, size_t size) {
+	BitReader bits(data, size);
+	Snapshot ret;
+
+	ret.tick = bits.read(32);
+	bool has_baseline = (bits.read(1) != 0);
+	if (has_baseline) {
+		uint32_t baseline_tick = bits.read(32);
+		if (!baseline || baseline->tick != baseline_tick) {
+			throw std::runtime_error("Snapshot was encoded against baseline tick " + std::to_string(baseline_tick) + ", which isn't the supplied baseline.");
+		}
+	} else {
+		baseline = nullptr;
+	}
+
+	static Snapshot::Portal const zero_portal;
+	for (uint32_t i = 0; i < 2; ++i) {
+		Snapshot::Portal const &base = (baseline ? baseline->portals[i] : zero_portal);
+		if (bits.read(1)) {
+			read_state(bits, base, &ret.portals[i]);
+		} else {
+			ret.portals[i] = base;
+		}
+	}
+
+	uint32_t count = bits.read_small(32);
+	//every food takes at least one bit, so this guards against allocating based on garbage:
+	if (count > size * 8) {
+		throw std::runtime_error("Snapshot data has invalid food count.");
+	}
+	ret.foods.resize(count);
+
+	static Snapshot::Food const zero_food;
+	Snapshot::Food const *base_food = (baseline ? baseline->foods.data() : nullptr);
+	Snapshot::Food const *base_end = (baseline ? baseline->foods.data() + baseline->foods.size() : nullptr);
+	uint32_t prev_id = 0;
+	for (auto &food : ret.foods) {
+		food.id = prev_id + 1 + bits.read_small(32);
+		prev_id = food.id;
+
+		while (base_food != base_end && base_food->id < food.id) ++base_food;
+		if (base_food != base_end && base_food->id == food.id) {
+			if (bits.read(1)) {
+				read_state(bits, *base_food, &food);
+			} else {
+				uint32_t id = food.id;
+				food = *base_food;
+				food.id = id;
+			}
+		} else {
+			read_state(bits, zero_food, &food);
+		}
+	}
+
+	return ret;
+}
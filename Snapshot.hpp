@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+struct GameMode;
+
+//"Snapshot" is a compact, quantized copy of the dynamic game state (foods + portals),
+// suitable for sending over the network or storing in a replay.
+//
+//Quantization:
+// - positions are quantized over the play area (x in [-70,70], y in [-60,50], plus a small margin)
+// - speeds are quantized over [-256,256] in each axis
+// - rotations are reduced to an angle around the z axis (the only axis gameplay rotates around)
+//
+//Snapshots are encoded relative to a 'baseline' (the last snapshot the other side acknowledged);
+// objects that didn't change cost one bit, and small changes cost a few bits per field.
+struct Snapshot {
+	struct Food {
+		uint32_t id = 0; //Scene::Object::id
+		uint16_t x = 0, y = 0; //quantized position
+		uint16_t speed_x = 0, speed_y = 0; //quantized speed
+		uint16_t angle = 0; //quantized rotation around z
+	};
+	struct Portal {
+		uint16_t x = 0, y = 0; //quantized position
+		uint16_t speed_x = 0, speed_y = 0; //quantized speed
+		uint16_t angle = 0; //quantized direction of normal
+	};
+
+	uint32_t tick = 0;
+	std::vector< Food > foods; //sorted by id
+	Portal portals[2];
+
+	//build a snapshot of the current state of a game:
+	static Snapshot capture(GameMode const &gm, uint32_t tick);
+
+	//quantization helpers:
+	static uint16_t quantize_x(float x);
+	static uint16_t quantize_y(float y);
+	static uint16_t quantize_speed(float s);
+	static uint16_t quantize_angle(float a);
+
+	static float dequantize_x(uint16_t q);
+	static float dequantize_y(uint16_t q);
+	static float dequantize_speed(uint16_t q);
+	static float dequantize_angle(uint16_t q);
+
+	//read back (dequantized) values:
+	static glm::vec2 position(Food const &f) { return glm::vec2(dequantize_x(f.x), dequantize_y(f.y)); }
+	static glm::vec2 speed(Food const &f) { return glm::vec2(dequantize_speed(f.speed_x), dequantize_speed(f.speed_y)); }
+	static float angle(Food const &f) { return dequantize_angle(f.angle); }
+};
+
+//encode 'snapshot' relative to 'baseline' and append the resulting bytes to 'out':
+// (pass baseline == nullptr for a self-contained snapshot)
+void encode_snapshot(Snapshot const *baseline, Snapshot const &snapshot, std::vector< uint8_t > *out);
+
+//decode a snapshot; 'baseline' must be the snapshot that the data was encoded against.
+// note: will throw if the data is truncated or was encoded against a different baseline.
+Snapshot decode_snapshot(Snapshot const *baseline, uint8_t const *data, size_t size);
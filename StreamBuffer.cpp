@@ -0,0 +1,68 @@
+#include "StreamBuffer.hpp"
+
+#include "gl_errors.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+
+StreamBuffer::StreamBuffer(GLsizeiptr region_size_) : region_size(region_size_) {
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, region_size * Regions, NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GL_ERRORS();
+}
+
+StreamBuffer::~StreamBuffer() {
+	for (auto &fence : fences) {
+		if (fence) glDeleteSync(fence);
+	}
+	glDeleteBuffers(1, &buffer);
+}
+
+GLintptr StreamBuffer::write(void const *data, GLsizeiptr bytes, GLsizeiptr alignment) {
+	GLsizeiptr base = region * region_size;
+	//(regions may not start at a multiple of 'alignment', so align the absolute offset)
+	GLsizeiptr at = (base + head + alignment - 1) / alignment * alignment;
+	if (at + bytes > base + region_size) {
+		if (overflows == 0) {
+			std::cerr << "WARNING: stream buffer region (" << region_size << " bytes) is full; dropping geometry." << std::endl;
+		}
+		overflows += 1;
+		return -1;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	//(the fence checked in next_frame says the GPU is done with this region, so no need to synchronize)
+	void *dst = glMapBufferRange(GL_ARRAY_BUFFER, at, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (!dst) {
+		throw std::runtime_error("Failed to map stream buffer.");
+	}
+	std::memcpy(dst, data, bytes);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	head = at + bytes - base;
+	return at;
+}
+
+void StreamBuffer::next_frame() {
+	if (head == 0) return; //nothing written this frame, so keep using the same region
+
+	if (fences[region]) glDeleteSync(fences[region]);
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	region = (region + 1) % Regions;
+	head = 0;
+
+	if (fences[region]) {
+		//the GPU has almost always finished with a region from 'Regions' frames ago; only wait if not:
+		if (glClientWaitSync(fences[region], 0, 0) == GL_TIMEOUT_EXPIRED) {
+			waits += 1;
+			glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+		}
+		glDeleteSync(fences[region]);
+		fences[region] = 0;
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "GL.hpp"
+
+//StreamBuffer holds vertex data that is rebuilt every frame (overlays, particles, ...).
+// The buffer is split into 'Regions' equal parts, and each frame writes into the next one
+// with unsynchronized glMapBufferRange calls, so the driver never has to stall (or copy) to
+// avoid overwriting data the GPU is still reading.
+// At each frame boundary a fence is placed after the frame's draws; the fence is checked
+// before the region is written again, 'Regions' frames later, and only waited on if the
+// GPU has fallen that far behind.
+//
+//(Persistent mapping -- GL 4.4 / ARB_buffer_storage -- would save the map/unmap calls, but
+// the game only asks for a 3.3 context.)
+//
+//Usage:
+//  GLintptr offset = stream.write(vertices.data(), vertices.size() * sizeof(Vertex), sizeof(Vertex));
+//  if (offset >= 0) glDrawArrays(GL_TRIANGLES, GLint(offset / sizeof(Vertex)), vertices.size());
+//  ...
+//  stream.next_frame(); //once per frame, after the last draw that uses this frame's data
+struct StreamBuffer {
+	StreamBuffer(GLsizeiptr region_size);
+	~StreamBuffer();
+
+	//copy 'bytes' bytes into this frame's region (at a multiple of 'alignment' from the start of the buffer);
+	// returns the offset written at, or -1 if this frame's region is full:
+	GLintptr write(void const *data, GLsizeiptr bytes, GLsizeiptr alignment = 16);
+
+	//fence this frame's region and move on to the next one:
+	void next_frame();
+
+	static constexpr uint32_t Regions = 3;
+
+	GLuint buffer = 0;
+	GLsizeiptr region_size = 0;
+	uint32_t region = 0; //region being written this frame
+	GLsizeiptr head = 0; //bytes used in 'region'
+	GLsync fences[Regions] = {0, 0, 0}; //signalled when the GPU is done with each region
+
+	uint32_t waits = 0; //times next_frame had to wait for the GPU
+	uint32_t overflows = 0; //writes dropped because a region was full
+};
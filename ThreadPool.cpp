@@ -0,0 +1,91 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+ThreadPool::ThreadPool(uint32_t worker_count) : next(0) {
+	if (worker_count == -1U) {
+		uint32_t hardware = std::thread::hardware_concurrency();
+		worker_count = (hardware > 1 ? hardware - 1 : 0);
+	}
+	workers.reserve(worker_count);
+	for (uint32_t i = 0; i < worker_count; ++i) {
+		workers.emplace_back(&ThreadPool::worker_main, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::work(std::function< void(uint32_t, uint32_t) > const &fn, uint32_t count, uint32_t chunk) {
+	while (true) {
+		uint32_t begin = next.fetch_add(chunk);
+		if (begin >= count) break;
+		fn(begin, std::min(count, begin + chunk));
+	}
+}
+
+void ThreadPool::worker_main() {
+	std::unique_lock< std::mutex > lock(mutex);
+	uint64_t seen = 0;
+	while (true) {
+		wake.wait(lock, [this,&seen](){ return quit || generation != seen; });
+		if (quit) break;
+		seen = generation;
+
+		//the job may have already finished (and been cleared) before this worker woke up:
+		if (job_fn == nullptr) continue;
+
+		std::function< void(uint32_t, uint32_t) > const &fn = *job_fn;
+		uint32_t count = job_count;
+		uint32_t chunk = job_chunk;
+		active += 1;
+		lock.unlock();
+
+		work(fn, count, chunk);
+
+		lock.lock();
+		active -= 1;
+		if (active == 0) done.notify_all();
+	}
+}
+
+void ThreadPool::parallel_for(uint32_t count, uint32_t chunk, std::function< void(uint32_t, uint32_t) > const &fn) {
+	assert(chunk > 0);
+	if (count == 0) return;
+
+	//not worth waking anyone up:
+	if (workers.empty() || count <= chunk) {
+		for (uint32_t begin = 0; begin < count; begin += chunk) {
+			fn(begin, std::min(count, begin + chunk));
+		}
+		return;
+	}
+
+	{ //post job:
+		std::unique_lock< std::mutex > lock(mutex);
+		assert(job_fn == nullptr && "parallel_for isn't re-entrant");
+		job_fn = &fn;
+		job_count = count;
+		job_chunk = chunk;
+		next = 0;
+		generation += 1;
+	}
+	wake.notify_all();
+
+	work(fn, count, chunk);
+
+	{ //wait for workers to finish their chunks, then clear job:
+		std::unique_lock< std::mutex > lock(mutex);
+		done.wait(lock, [this](){ return active == 0; });
+		job_fn = nullptr;
+	}
+}
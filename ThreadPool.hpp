@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//ThreadPool runs data-parallel loops on a fixed set of worker threads.
+// The thread calling parallel_for also does work, so a pool with N workers runs loops N+1 wide.
+struct ThreadPool {
+	//worker_count == -1U means "one fewer than the number of hardware threads":
+	ThreadPool(uint32_t worker_count = -1U);
+	~ThreadPool();
+
+	//call fn(begin, end) for chunks of at most 'chunk' items covering [0, count):
+	// returns once every chunk is done. fn must be safe to call from several threads at once, and must not throw.
+	void parallel_for(uint32_t count, uint32_t chunk, std::function< void(uint32_t, uint32_t) > const &fn);
+
+	//internals:
+	void worker_main();
+	void work(std::function< void(uint32_t, uint32_t) > const &fn, uint32_t count, uint32_t chunk);
+
+	std::vector< std::thread > workers;
+
+	std::mutex mutex; //protects everything below except 'next'
+	std::condition_variable wake; //signalled when a job is posted or on shutdown
+	std::condition_variable done; //signalled when the last worker leaves a job
+	bool quit = false;
+	uint64_t generation = 0; //incremented for every posted job
+	uint32_t active = 0; //workers currently running chunks of the job
+
+	//current job (job_fn is nullptr when there isn't one):
+	std::function< void(uint32_t, uint32_t) > const *job_fn = nullptr;
+	uint32_t job_count = 0;
+	uint32_t job_chunk = 0;
+	std::atomic< uint32_t > next; //first item of the next chunk to hand out
+};
@@ -1,29 +1,99 @@
 #include "WalkMesh.hpp"
 
 #include "read_chunk.hpp"
+#include "ThreadPool.hpp"
 
 #include <glm/gtx/norm.hpp>
 
+#include <atomic>
+#include <cassert>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <string>
+#include <functional>
 
 WalkMesh::WalkMesh(std::vector< glm::vec3 > const &vertices_, std::vector< glm::vec3 > const &normals_, std::vector< glm::uvec3 > const &triangles_)
 	: vertices(vertices_), normals(normals_), triangles(triangles_) {
 
-	//construct next_vertex map (maps each edge to the next vertex in the triangle):
-	next_vertex.reserve(triangles.size()*3);
-	auto do_next = [this](uint32_t a, uint32_t b, uint32_t c) {
-		auto ret = next_vertex.insert(std::make_pair(glm::uvec2(a,b), c));
-		assert(ret.second);
-	};
-	for (auto const &tri : triangles) {
-		do_next(tri.x, tri.y, tri.z);
-		do_next(tri.y, tri.z, tri.x);
-		do_next(tri.z, tri.x, tri.y);
+	//construct opposite array by sorting half-edges so each one's twin can be found by binary search:
+	{
+		std::vector< std::pair< uint64_t, uint32_t > > half_edges; //((from << 32) | to, half-edge index)
+		half_edges.reserve(triangles.size()*3);
+		for (uint32_t t = 0; t < triangles.size(); ++t) {
+			for (uint32_t k = 0; k < 3; ++k) {
+				uint64_t from = triangles[t][k];
+				uint64_t to = triangles[t][(k+1)%3];
+				half_edges.emplace_back((from << 32) | to, 3*t+k);
+			}
+		}
+		std::sort(half_edges.begin(), half_edges.end());
+
+		opposite.assign(triangles.size()*3, -1U);
+		for (uint32_t i = 0; i < half_edges.size(); ++i) {
+			assert((i == 0 || half_edges[i-1].first != half_edges[i].first) && "each directed edge should appear in at most one triangle");
+			uint64_t key = half_edges[i].first;
+			uint64_t twin = (key << 32) | (key >> 32);
+			auto f = std::lower_bound(half_edges.begin(), half_edges.end(), std::make_pair(twin, uint32_t(0)));
+			if (f != half_edges.end() && f->first == twin) {
+				opposite[half_edges[i].second] = f->second;
+			}
+		}
+	}
+
+	//build bvh by recursively splitting triangles at the median centroid along the longest axis:
+	if (!triangles.empty()) {
+		std::vector< glm::vec3 > centroids;
+		centroids.reserve(triangles.size());
+		bvh_triangles.reserve(triangles.size());
+		for (auto const &tri : triangles) {
+			bvh_triangles.emplace_back(uint32_t(centroids.size()));
+			centroids.emplace_back((vertices[tri.x] + vertices[tri.y] + vertices[tri.z]) / 3.0f);
+		}
+		bvh_nodes.reserve(2 * (triangles.size() / 4 + 1));
+
+		const uint32_t LeafSize = 4;
+		std::function< uint32_t(uint32_t, uint32_t) > build = [&](uint32_t begin, uint32_t end) -> uint32_t {
+			uint32_t index = uint32_t(bvh_nodes.size());
+			bvh_nodes.emplace_back();
+			BVHNode node;
+			node.min = glm::vec3( std::numeric_limits< float >::infinity());
+			node.max = glm::vec3(-std::numeric_limits< float >::infinity());
+			node.begin = begin;
+			node.end = end;
+			node.right = 0;
+			glm::vec3 centroid_min = node.min;
+			glm::vec3 centroid_max = node.max;
+			for (uint32_t i = begin; i < end; ++i) {
+				glm::uvec3 const &tri = triangles[bvh_triangles[i]];
+				for (uint32_t v : {tri.x, tri.y, tri.z}) {
+					node.min = glm::min(node.min, vertices[v]);
+					node.max = glm::max(node.max, vertices[v]);
+				}
+				centroid_min = glm::min(centroid_min, centroids[bvh_triangles[i]]);
+				centroid_max = glm::max(centroid_max, centroids[bvh_triangles[i]]);
+			}
+
+			if (end - begin > LeafSize) {
+				glm::vec3 extent = centroid_max - centroid_min;
+				int axis = 0;
+				if (extent.y > extent[axis]) axis = 1;
+				if (extent.z > extent[axis]) axis = 2;
+				uint32_t mid = begin + (end - begin) / 2;
+				std::nth_element(bvh_triangles.begin() + begin, bvh_triangles.begin() + mid, bvh_triangles.begin() + end, [&](uint32_t a, uint32_t b) {
+					return centroids[a][axis] < centroids[b][axis];
+				});
+				build(begin, mid);
+				node.right = build(mid, end);
+			}
+
+			bvh_nodes[index] = node;
+			return index;
+		};
+		build(0, uint32_t(triangles.size()));
 	}
 
+	#ifndef NDEBUG
 	//DEBUG: are vertex normals consistent with geometric normals?
 	for (auto const &tri : triangles) {
 		glm::vec3 const &a = vertices[tri.x];
@@ -37,84 +107,175 @@ WalkMesh::WalkMesh(std::vector< glm::vec3 > const &vertices_, std::vector< glm::
 
 		assert(da > 0.1f && db > 0.1f && dc > 0.1f);
 	}
+	#endif
 }
 
-WalkMesh::WalkPoint WalkMesh::start(glm::vec3 const &world_point) const {
-	WalkPoint closest;
-	float closest_dis2 = std::numeric_limits< float >::infinity();
-	for (auto const &tri : triangles) {
-		glm::vec3 const &a = vertices[tri.x];
-		glm::vec3 const &b = vertices[tri.y];
-		glm::vec3 const &c = vertices[tri.z];
+//update closest/closest_dis2 if some point of triangle 'tri' is closer to world_point:
+static void check_triangle(std::vector< glm::vec3 > const &vertices, uint32_t face, glm::uvec3 const &tri, glm::vec3 const &world_point, WalkMesh::WalkPoint *closest_, float *closest_dis2_) {
+	WalkMesh::WalkPoint &closest = *closest_;
+	float &closest_dis2 = *closest_dis2_;
+
+	glm::vec3 const &a = vertices[tri.x];
+	glm::vec3 const &b = vertices[tri.y];
+	glm::vec3 const &c = vertices[tri.z];
+
+	//figure out barycentric coordinates for point:
+	//project to plane of triangle:
+	glm::vec3 out = glm::cross(b-a, c-a);
+	glm::vec3 pt = world_point - out * (glm::dot(out, world_point - a) / glm::dot(out, out));
+
+	//figure out barycentric coordinates using signed triangle areas:
+	glm::vec3 coords = glm::vec3(
+		glm::dot(out, glm::cross(c-b, pt-b)),
+		glm::dot(out, glm::cross(a-c, pt-c)),
+		glm::dot(out, glm::cross(b-a, pt-a))
+	) / glm::dot(out, glm::cross(b-a, c-a));
+
+	//is point inside triangle?
+	if (coords.x >= 0.0f && coords.y >= 0.0f && coords.z >= 0.0f) {
+		//yes, point is inside triangle.
+		float dis2 = glm::length2(world_point - pt);
+		if (dis2 < closest_dis2) {
+			closest_dis2 = dis2;
+			closest.face = face;
+			closest.triangle = tri;
+			closest.weights = coords;
+		}
+	} else {
+		//check triangle vertices and edges:
+		auto check_edge = [&world_point, &closest, &closest_dis2, &vertices, face](uint32_t ai, uint32_t bi, uint32_t ci) {
+			glm::vec3 const &a = vertices[ai];
+			glm::vec3 const &b = vertices[bi];
+
+			//find closest point on line segment ab:
+			float along = glm::dot(world_point-a, b-a);
+			float max = glm::dot(b-a, b-a);
+			glm::vec3 pt;
+			glm::vec3 coords;
+			if (along < 0.0f) {
+				pt = a;
+				coords = glm::vec3(1.0f, 0.0f, 0.0f);
+			} else if (along > max) {
+				pt = b;
+				coords = glm::vec3(0.0f, 1.0f, 0.0f);
+			} else {
+				float amt = along / max;
+				pt = glm::mix(a, b, amt);
+				coords = glm::vec3(1.0f - amt, amt, 0.0f);
+			}
 
-		//figure out barycentric coordinates for point:
-		//project to plane of triangle:
-		glm::vec3 out = glm::cross(b-a, c-a);
-		glm::vec3 pt = world_point - out * (glm::dot(out, world_point) / glm::dot(out, out));
-
-		//figure out barycentric coordinates using signed triangle areas:
-		glm::vec3 coords = glm::vec3(
-			glm::dot(out, glm::cross(c-b, pt-b)),
-			glm::dot(out, glm::cross(a-c, pt-c)),
-			glm::dot(out, glm::cross(b-a, pt-a))
-		) / glm::dot(out, glm::cross(b-a, c-a));
-
-		//is point inside triangle?
-		if (coords.x >= 0.0f && coords.y >= 0.0f && coords.z >= 0.0f) {
-			//yes, point is inside triangle.
 			float dis2 = glm::length2(world_point - pt);
 			if (dis2 < closest_dis2) {
 				closest_dis2 = dis2;
-				closest.triangle = tri;
+				closest.face = face;
+				closest.triangle = glm::uvec3(ai, bi, ci);
 				closest.weights = coords;
 			}
-		} else {
-			//check triangle vertices and edges:
-			auto check_edge = [&world_point, &closest, &closest_dis2, this](uint32_t ai, uint32_t bi, uint32_t ci) {
-				glm::vec3 const &a = vertices[ai];
-				glm::vec3 const &b = vertices[bi];
-
-				//find closest point on line segment ab:
-				float along = glm::dot(world_point-a, b-a);
-				float max = glm::dot(b-a, b-a);
-				glm::vec3 pt;
-				glm::vec3 coords;
-				if (along < 0.0f) {
-					pt = a;
-					coords = glm::vec3(1.0f, 0.0f, 0.0f);
-				} else if (along > max) {
-					pt = b;
-					coords = glm::vec3(0.0f, 1.0f, 0.0f);
-				} else {
-					float amt = along / max;
-					pt = glm::mix(a, b, amt);
-					coords = glm::vec3(1.0f - amt, amt, 0.0f);
-				}
+		};
+		check_edge(tri.x, tri.y, tri.z);
+		check_edge(tri.y, tri.z, tri.x);
+		check_edge(tri.z, tri.x, tri.y);
+	}
+}
 
-				float dis2 = glm::length2(world_point - pt);
-				if (dis2 < closest_dis2) {
-					closest_dis2 = dis2;
-					closest.triangle = glm::uvec3(ai, bi, ci);
-					closest.weights = coords;
-				}
-			};
-			check_edge(tri.x, tri.y, tri.z);
-			check_edge(tri.y, tri.z, tri.x);
-			check_edge(tri.z, tri.x, tri.y);
+//squared distance from a point to a node's bounding box:
+static float box_dis2(WalkMesh::BVHNode const &node, glm::vec3 const &pt) {
+	glm::vec3 d = glm::max(glm::max(node.min - pt, pt - node.max), glm::vec3(0.0f));
+	return glm::dot(d, d);
+}
+
+void WalkMesh::find_closest(glm::vec3 const &world_point, WalkPoint *closest, float *closest_dis2) const {
+	if (bvh_nodes.empty()) return;
+
+	//visit nodes nearest-first, skipping any that can't contain something closer than the current best:
+	uint32_t stack[64];
+	uint32_t stack_size = 0;
+	stack[stack_size++] = 0;
+	while (stack_size) {
+		uint32_t index = stack[--stack_size];
+		BVHNode const &node = bvh_nodes[index];
+		if (box_dis2(node, world_point) >= *closest_dis2) continue;
+
+		if (node.right == 0) {
+			for (uint32_t i = node.begin; i < node.end; ++i) {
+				uint32_t face = bvh_triangles[i];
+				check_triangle(vertices, face, triangles[face], world_point, closest, closest_dis2);
+			}
+			continue;
 		}
+
+		uint32_t near = index + 1;
+		uint32_t far = node.right;
+		if (box_dis2(bvh_nodes[far], world_point) < box_dis2(bvh_nodes[near], world_point)) {
+			std::swap(near, far);
+		}
+		assert(stack_size + 2 <= 64 && "BVH is deeper than expected");
+		stack[stack_size++] = far;
+		stack[stack_size++] = near;
 	}
+}
+
+WalkMesh::WalkPoint WalkMesh::start(glm::vec3 const &world_point) const {
+	WalkPoint closest;
+	float closest_dis2 = std::numeric_limits< float >::infinity();
+	find_closest(world_point, &closest, &closest_dis2);
 	return closest;
 }
 
+void WalkMesh::start_many(std::vector< glm::vec3 > const &world_points, std::vector< WalkPoint > *walk_points_) const {
+	assert(walk_points_);
+	auto &walk_points = *walk_points_;
+	walk_points.assign(world_points.size(), WalkPoint());
+	if (bvh_nodes.empty()) return;
+
+	//handle points in Morton (z-curve) order so that consecutive queries are near each other:
+	glm::vec3 min = bvh_nodes[0].min;
+	glm::vec3 scale = glm::vec3(1023.0f) / glm::max(bvh_nodes[0].max - min, glm::vec3(1e-6f));
+	auto spread = [](uint32_t v) {
+		//put two zero bits between each of the low 10 bits of v:
+		v = (v | (v << 16)) & 0x030000ff;
+		v = (v | (v << 8)) & 0x0300f00f;
+		v = (v | (v << 4)) & 0x030c30c3;
+		v = (v | (v << 2)) & 0x09249249;
+		return v;
+	};
+	std::vector< std::pair< uint32_t, uint32_t > > order; //(morton code, index)
+	order.reserve(world_points.size());
+	for (uint32_t i = 0; i < world_points.size(); ++i) {
+		glm::vec3 q = glm::clamp((world_points[i] - min) * scale, 0.0f, 1023.0f);
+		uint32_t code = spread(uint32_t(q.x)) | (spread(uint32_t(q.y)) << 1) | (spread(uint32_t(q.z)) << 2);
+		order.emplace_back(code, i);
+	}
+	std::sort(order.begin(), order.end());
+
+	//the previous answer is usually close to the next one, so check it first to get a tight bound:
+	WalkPoint const *previous = nullptr;
+	for (auto const &o : order) {
+		glm::vec3 const &world_point = world_points[o.second];
+		WalkPoint &closest = walk_points[o.second];
+		float closest_dis2 = std::numeric_limits< float >::infinity();
+		if (previous && previous->face != -1U) {
+			check_triangle(vertices, previous->face, triangles[previous->face], world_point, &closest, &closest_dis2);
+		}
+		find_closest(world_point, &closest, &closest_dis2);
+		previous = &closest;
+	}
+}
+
 void WalkMesh::walk(WalkMesh::WalkPoint &wp, glm::vec3 const &step) const {
+	if (!try_walk(wp, step)) {
+		std::cerr << "WARNING: Couldn't resolve step in ten iterations, discarding the rest." << std::endl;
+	}
+}
+
+bool WalkMesh::try_walk(WalkMesh::WalkPoint &wp, glm::vec3 const &step) const {
 
 	glm::vec3 remain = step;
 
 	uint32_t iter = 0;
 	while (remain != glm::vec3(0.0f)) {
 		if (iter > 10) {
-			std::cerr << "WARNING: Couldn't resolve step in ten iterations, discarding the rest." << std::endl;
-			break;
+			return false;
 		}
 		iter += 1;
 
@@ -146,6 +307,7 @@ void WalkMesh::walk(WalkMesh::WalkPoint &wp, glm::vec3 const &step) const {
 
 		float t = 1.0f;
 		glm::uvec2 edge = glm::uvec2(-1U); uint32_t other = -1U;
+		uint32_t half_edge = -1U;
 		glm::vec2 edge_coords = glm::vec2(std::numeric_limits< float >::quiet_NaN());
 		{ //figure out when (if ever) and where an edge is crossed:
 			#define TEST_COORD( C, A, B ) \
@@ -154,6 +316,7 @@ void WalkMesh::walk(WalkMesh::WalkPoint &wp, glm::vec3 const &step) const {
 					if (test < t) { \
 						t = test; \
 						edge = glm::uvec2(wp.triangle.A, wp.triangle.B); other = wp.triangle.C; \
+						half_edge = 3 * wp.face + (triangles[wp.face].x == edge.x ? 0 : (triangles[wp.face].y == edge.x ? 1 : 2)); \
 						edge_coords = glm::vec2(t * remain_coords.A + wp.weights.A, t * remain_coords.B + wp.weights.B); \
 					} \
 				}
@@ -178,8 +341,9 @@ void WalkMesh::walk(WalkMesh::WalkPoint &wp, glm::vec3 const &step) const {
 		remain *= (1.0f - t);
 
 		//is edge solid?
-		auto f = next_vertex.find(glm::uvec2(edge.y, edge.x));
-		if (f == next_vertex.end()) {
+		assert(half_edge != -1U);
+		uint32_t twin = opposite[half_edge];
+		if (twin == -1U) {
 			//if yes, move remain to point (slightly) inward:
 			glm::vec3 along = glm::normalize(vertices[edge.y] - vertices[edge.x]);
 			glm::vec3 in = vertices[other] - vertices[edge.x];
@@ -192,10 +356,13 @@ void WalkMesh::walk(WalkMesh::WalkPoint &wp, glm::vec3 const &step) const {
 			//NOTE: this probably results in an infinite loop when walking into a corner.
 		} else {
 			//if no, move to new triangle:
-			assert(f->second != other);
+			uint32_t next_face = twin / 3;
+			uint32_t next_other = triangles[next_face][(twin % 3 + 2) % 3];
+			assert(next_other != other);
 
 			//update triangle and weights:
-			wp.triangle = glm::uvec3(edge.y, edge.x, f->second);
+			wp.face = next_face;
+			wp.triangle = glm::uvec3(edge.y, edge.x, next_other);
 			wp.weights = glm::vec3(edge_coords.y, edge_coords.x, 0.0f);
 
 			//rotate 'remain' around edge:
@@ -203,7 +370,7 @@ void WalkMesh::walk(WalkMesh::WalkPoint &wp, glm::vec3 const &step) const {
 			glm::vec3 to_old_other = vertices[other] - vertices[edge.x];
 			to_old_other = glm::normalize(to_old_other - along * glm::dot(along, to_old_other));
 
-			glm::vec3 to_new_other = vertices[f->second] - vertices[edge.y];
+			glm::vec3 to_new_other = vertices[next_other] - vertices[edge.y];
 			to_new_other = glm::normalize(to_new_other - along * glm::dot(along, to_new_other));
 
 			float d = glm::dot(remain, -to_old_other); //amount of 'remain' sticking out of old triangle
@@ -212,8 +379,43 @@ void WalkMesh::walk(WalkMesh::WalkPoint &wp, glm::vec3 const &step) const {
 			remain += d * to_new_other; //add it back in sticking out in plane of new triangle
 		}
 	}
+	return true;
 }
 
+void WalkMesh::walk_many(ThreadPool &pool, std::vector< WalkPoint > *walk_points_, std::vector< glm::vec3 > const &steps,
+	std::vector< glm::vec3 > *positions, std::vector< glm::vec3 > *normals) const {
+	assert(walk_points_);
+	auto &walk_points = *walk_points_;
+	assert(steps.size() == walk_points.size());
+
+	if (positions) positions->resize(walk_points.size());
+	if (normals) normals->resize(walk_points.size());
+
+	//the mesh is only read, and each chunk touches its own range of the arrays, so chunks can run in parallel:
+	// (steps that can't be resolved are counted and reported once, rather than from every worker)
+	std::atomic< uint32_t > failed(0);
+	pool.parallel_for(uint32_t(walk_points.size()), 256, [&](uint32_t begin, uint32_t end) {
+		uint32_t chunk_failed = 0;
+		for (uint32_t i = begin; i < end; ++i) {
+			if (!try_walk(walk_points[i], steps[i])) chunk_failed += 1;
+		}
+		if (chunk_failed) failed += chunk_failed;
+		if (positions) {
+			for (uint32_t i = begin; i < end; ++i) {
+				(*positions)[i] = world_point(walk_points[i]);
+			}
+		}
+		if (normals) {
+			for (uint32_t i = begin; i < end; ++i) {
+				(*normals)[i] = world_normal(walk_points[i]);
+			}
+		}
+	});
+
+	if (failed) {
+		std::cerr << "WARNING: Couldn't resolve " << failed << " of " << walk_points.size() << " steps in ten iterations, discarding the rest of them." << std::endl;
+	}
+}
 
 WalkMeshes::WalkMeshes(std::string const &filename) {
 	std::ifstream file(filename, std::ios::binary);
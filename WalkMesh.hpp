@@ -1,11 +1,13 @@
 #pragma once
 
+#include <glm/glm.hpp>
+
 #include <vector>
-#include <unordered_map>
 #include <map>
+#include <limits>
+#include <string>
 
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp> //allows the use of 'uvec2' as an unordered_map key
+struct ThreadPool;
 
 struct WalkMesh {
 	//Walk mesh will keep track of triangles, vertices:
@@ -13,15 +15,26 @@ struct WalkMesh {
 	std::vector< glm::vec3 > normals; //normals for interpolated 'up' direction
 	std::vector< glm::uvec3 > triangles; //CCW-oriented
 
-	//This "next vertex" map includes [a,b]->c, [b,c]->a, and [c,a]->b for each triangle, and is useful for checking what's over an edge from a given point:
-	std::unordered_map< glm::uvec2, uint32_t > next_vertex;
+	//Half-edge adjacency: half-edge 3*t+k runs from triangles[t][k] to triangles[t][(k+1)%3];
+	// opposite[3*t+k] is the half-edge running the other way along the same edge (in the neighboring triangle), or -1U if the edge is solid:
+	std::vector< uint32_t > opposite;
+
 
+	//Bounding volume hierarchy over triangles, used to speed up start():
+	struct BVHNode {
+		glm::vec3 min, max; //bounds of all triangles under this node
+		uint32_t begin, end; //range of bvh_triangles under this node
+		uint32_t right; //index of second child (first child is the next node), or 0 for a leaf
+	};
+	std::vector< BVHNode > bvh_nodes; //depth-first order; bvh_nodes[0] is the root
+	std::vector< uint32_t > bvh_triangles; //triangle indices, ordered so every node covers a contiguous range
 
-	//Construct new WalkMesh and build next_vertex structure:
+	//Construct new WalkMesh and build opposite + bvh structures:
 	WalkMesh(std::vector< glm::vec3 > const &vertices_, std::vector< glm::vec3 > const &normals_, std::vector< glm::uvec3 > const &triangles_);
 
 	struct WalkPoint {
-		glm::uvec3 triangle = glm::uvec3(-1U); //indices of current triangle
+		uint32_t face = -1U; //index of current triangle in 'triangles'
+		glm::uvec3 triangle = glm::uvec3(-1U); //indices of current triangle (some rotation of triangles[face])
 		glm::vec3 weights = glm::vec3(std::numeric_limits< float >::quiet_NaN()); //barycentric coordinates for current point
 	};
 
@@ -29,9 +42,18 @@ struct WalkMesh {
 	// (should only need to call this at the start of a level)
 	WalkPoint start(glm::vec3 const &world_point) const;
 
+	//start() for many points at once (faster than separate calls when points are near each other):
+	void start_many(std::vector< glm::vec3 > const &world_points, std::vector< WalkPoint > *walk_points) const;
+
 	//used to update walk point:
 	void walk(WalkPoint &wp, glm::vec3 const &step) const;
 
+	//walk() for many walk points at once, split across the threads of 'pool':
+	// walk_points[i] is advanced by steps[i]; the resulting world_point() and world_normal()
+	// values are written to positions[i] and normals[i] (pass nullptr to skip either).
+	void walk_many(ThreadPool &pool, std::vector< WalkPoint > *walk_points, std::vector< glm::vec3 > const &steps,
+		std::vector< glm::vec3 > *positions, std::vector< glm::vec3 > *normals) const;
+
 	//used to read back results of walking:
 	glm::vec3 world_point(WalkPoint const &wp) const {
 		return wp.weights.x * vertices[wp.triangle.x]
@@ -47,6 +69,12 @@ struct WalkMesh {
 		);
 	}
 
+	//internals:
+	//walk() without the warning; returns false if the step couldn't be resolved (the rest of it is discarded):
+	bool try_walk(WalkPoint &wp, glm::vec3 const &step) const;
+
+	//closest point search that can only improve on the passed-in closest/closest_dis2:
+	void find_closest(glm::vec3 const &world_point, WalkPoint *closest, float *closest_dis2) const;
 };
 
 struct WalkMeshes {
@@ -95,4 +123,19 @@ Game::update(float elapsed) {
 	player_right = glm::cross(player_forward, player_up);
 
 }
+
+// ...and crowds of walkers can be updated together:
+
+Crowd {
+	std::vector< WalkPoint > walk_points;
+	std::vector< glm::vec3 > steps, positions, normals;
+}
+
+Crowd::update(float elapsed) {
+	for (uint32_t i = 0; i < walk_points.size(); ++i) {
+		steps[i] = walker_forward[i] * speed * elapsed;
+	}
+	walk_mesh->walk_many(thread_pool, &walk_points, steps, &positions, &normals);
+	//...then update orientations from 'normals' as above.
+}
 */
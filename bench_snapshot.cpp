@@ -0,0 +1,92 @@
+//Benchmark for the snapshot codec (Snapshot.hpp): encoded size and encode/decode time per tick
+// for 100, 1k, and 10k foods, each tick encoded against the previous one as its baseline.
+//Built only when asked for -- jam -sBENCH=1 -- as dist/bench_snapshot.
+
+#include "Snapshot.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+static double now() {
+	return std::chrono::duration< double >(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char **argv) {
+	uint32_t const Ticks = 120;
+
+	for (uint32_t count : {100U, 1000U, 10000U}) {
+		std::mt19937 mt(0x5eed);
+
+		//foods spread over the play area; a quarter of them sit still (in pots, on the table), the rest fall:
+		std::vector< glm::vec2 > positions(count), speeds(count);
+		std::vector< float > angles(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			positions[i] = glm::vec2(std::uniform_real_distribution< float >(-60.0f, 60.0f)(mt), std::uniform_real_distribution< float >(-50.0f, 40.0f)(mt));
+			speeds[i] = (i % 4 == 0 ? glm::vec2(0.0f) : glm::vec2(std::uniform_real_distribution< float >(-10.0f, 10.0f)(mt), 0.0f));
+			angles[i] = std::uniform_real_distribution< float >(-3.0f, 3.0f)(mt);
+		}
+
+		auto capture = [&](uint32_t tick) {
+			Snapshot snapshot;
+			snapshot.tick = tick;
+			snapshot.foods.resize(count);
+			for (uint32_t i = 0; i < count; ++i) {
+				Snapshot::Food &food = snapshot.foods[i];
+				food.id = i + 1;
+				food.x = Snapshot::quantize_x(positions[i].x);
+				food.y = Snapshot::quantize_y(positions[i].y);
+				food.speed_x = Snapshot::quantize_speed(speeds[i].x);
+				food.speed_y = Snapshot::quantize_speed(speeds[i].y);
+				food.angle = Snapshot::quantize_angle(angles[i]);
+			}
+			return snapshot;
+		};
+
+		Snapshot baseline = capture(0);
+		double encode_time = 0.0, decode_time = 0.0;
+		size_t bytes = 0;
+		std::vector< uint8_t > data;
+		for (uint32_t tick = 1; tick <= Ticks; ++tick) {
+			float const elapsed = 1.0f / 120.0f;
+			for (uint32_t i = 0; i < count; ++i) {
+				if (i % 4 == 0) continue;
+				speeds[i].y -= 9.8f * elapsed;
+				positions[i].x += speeds[i].x * elapsed;
+				positions[i].y += speeds[i].y * elapsed;
+				angles[i] += elapsed;
+				if (positions[i].y < -50.0f) { positions[i].y = 40.0f; speeds[i].y = 0.0f; }
+			}
+			Snapshot snapshot = capture(tick);
+
+			data.clear();
+			double before = now();
+			encode_snapshot(&baseline, snapshot, &data);
+			double after = now();
+			Snapshot decoded = decode_snapshot(&baseline, data.data(), data.size());
+			double done = now();
+
+			encode_time += after - before;
+			decode_time += done - after;
+			bytes += data.size();
+
+			if (decoded.foods.size() != snapshot.foods.size()) throw std::runtime_error("Decoded snapshot has the wrong number of foods.");
+			for (uint32_t i = 0; i < count; ++i) {
+				Snapshot::Food const &a = decoded.foods[i], &b = snapshot.foods[i];
+				if (a.id != b.id || a.x != b.x || a.y != b.y || a.speed_x != b.speed_x || a.speed_y != b.speed_y || a.angle != b.angle) {
+					throw std::runtime_error("Decoded snapshot doesn't match.");
+				}
+			}
+			baseline = snapshot;
+		}
+
+		std::cout << count << " foods: " << (bytes / Ticks) << " bytes/tick, encode "
+			<< (encode_time / Ticks) * 1000.0 << "ms, decode " << (decode_time / Ticks) * 1000.0 << "ms"
+			<< " (raw floats: " << count * 11 * 4 << " bytes)" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+//Benchmark for WalkMesh (WalkMesh.hpp): building the adjacency + BVH, start() vs. start_many(),
+// and a loop of walk() calls vs. walk_many() on a ThreadPool, for a crowd on a rolling heightfield.
+//Built only when asked for -- jam -sBENCH=1 -- as dist/bench_walkmesh.
+
+#include "WalkMesh.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+static double now() {
+	return std::chrono::duration< double >(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char **argv) {
+	uint32_t const Size = 224; //(224 x 224 quads ~= 100k triangles)
+	uint32_t const Agents = 10000;
+	uint32_t const Frames = 60;
+
+	//rolling heightfield, with normals from the height function's gradient:
+	auto height = [](float x, float y) { return 2.0f * std::sin(0.2f * x) * std::cos(0.15f * y); };
+	std::vector< glm::vec3 > vertices, normals;
+	std::vector< glm::uvec3 > triangles;
+	for (uint32_t y = 0; y <= Size; ++y) {
+		for (uint32_t x = 0; x <= Size; ++x) {
+			float fx = float(x), fy = float(y);
+			vertices.emplace_back(fx, fy, height(fx, fy));
+			float dx = 0.4f * std::cos(0.2f * fx) * std::cos(0.15f * fy);
+			float dy = -0.3f * std::sin(0.2f * fx) * std::sin(0.15f * fy);
+			normals.emplace_back(glm::normalize(glm::vec3(-dx, -dy, 1.0f)));
+		}
+	}
+	for (uint32_t y = 0; y < Size; ++y) {
+		for (uint32_t x = 0; x < Size; ++x) {
+			uint32_t i = y * (Size + 1) + x;
+			triangles.emplace_back(i, i + 1, i + Size + 2);
+			triangles.emplace_back(i, i + Size + 2, i + Size + 1);
+		}
+	}
+
+	double before = now();
+	WalkMesh mesh(vertices, normals, triangles);
+	std::cout << triangles.size() << " triangles: built adjacency + BVH in " << (now() - before) * 1000.0 << "ms" << std::endl;
+
+	std::mt19937 mt(0x5eed);
+	std::uniform_real_distribution< float > coord(1.0f, float(Size) - 1.0f);
+	std::vector< glm::vec3 > starts(Agents);
+	for (auto &s : starts) {
+		s = glm::vec3(coord(mt), coord(mt), 0.0f);
+		s.z = height(s.x, s.y) + 0.5f;
+	}
+
+	std::vector< WalkMesh::WalkPoint > one_by_one(Agents);
+	before = now();
+	for (uint32_t i = 0; i < Agents; ++i) {
+		one_by_one[i] = mesh.start(starts[i]);
+	}
+	double start_time = now() - before;
+
+	std::vector< WalkMesh::WalkPoint > batched;
+	before = now();
+	mesh.start_many(starts, &batched);
+	double start_many_time = now() - before;
+
+	//(on ties -- a point closest to a shared edge -- the two may pick different faces, so compare distances)
+	for (uint32_t i = 0; i < Agents; ++i) {
+		float a = glm::length(mesh.world_point(one_by_one[i]) - starts[i]);
+		float b = glm::length(mesh.world_point(batched[i]) - starts[i]);
+		if (std::abs(a - b) > 1e-4f) throw std::runtime_error("start() and start_many() disagree.");
+	}
+	batched = one_by_one; //(so the walks below start from identical points)
+	std::cout << Agents << " agents: start() " << start_time * 1000.0 << "ms, start_many() " << start_many_time * 1000.0 << "ms" << std::endl;
+
+	//everyone wanders in a slowly turning direction:
+	std::vector< glm::vec3 > steps(Agents);
+	auto set_steps = [&](uint32_t frame) {
+		for (uint32_t i = 0; i < Agents; ++i) {
+			float a = 0.01f * float(i) + 0.05f * float(frame);
+			steps[i] = glm::vec3(std::cos(a), std::sin(a), 0.0f) * (5.0f / 60.0f);
+		}
+	};
+
+	std::vector< glm::vec3 > serial_positions(Agents), serial_normals(Agents);
+	before = now();
+	for (uint32_t frame = 0; frame < Frames; ++frame) {
+		set_steps(frame);
+		for (uint32_t i = 0; i < Agents; ++i) {
+			mesh.walk(one_by_one[i], steps[i]);
+			serial_positions[i] = mesh.world_point(one_by_one[i]);
+			serial_normals[i] = mesh.world_normal(one_by_one[i]);
+		}
+	}
+	double walk_time = now() - before;
+
+	ThreadPool pool;
+	std::vector< glm::vec3 > positions, normals_out;
+	before = now();
+	for (uint32_t frame = 0; frame < Frames; ++frame) {
+		set_steps(frame);
+		mesh.walk_many(pool, &batched, steps, &positions, &normals_out);
+	}
+	double walk_many_time = now() - before;
+
+	for (uint32_t i = 0; i < Agents; ++i) {
+		if (positions[i] != serial_positions[i]) throw std::runtime_error("walk() and walk_many() disagree.");
+	}
+	std::cout << Agents << " agents, " << pool.workers.size() + 1 << " threads: walk() + readback " << (walk_time / Frames) * 1000.0
+		<< "ms/frame, walk_many() " << (walk_many_time / Frames) * 1000.0 << "ms/frame" << std::endl;
+
+	return 0;
+}
@@ -1,9 +1,25 @@
 #include "compile_program.hpp"
 
+#include "data_path.hpp"
+
+#include <SDL.h>
+
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+ProgramCacheStats program_cache_stats;
 
 static GLuint compile_shader(GLenum type, std::string const &source) {
 	GLuint shader = glCreateShader(type);
@@ -27,15 +43,182 @@ static GLuint compile_shader(GLenum type, std::string const &source) {
 	return shader;
 }
 
+//------------------------------------------
+//Program binary cache:
+// Linked programs are saved to data_path("shader_cache/<key>.bin"), where the key is a hash of
+// the shader sources and the driver's vendor/renderer/version strings (so driver updates or
+// different GPUs never load each other's binaries). If the driver rejects a cached binary,
+// the program is compiled from source again and the cache entry is replaced.
+//
+//File layout:
+// "pbc0", key (uint64), format (uint32), compile time in ms (float), binary size (uint32), binary
+
+//program binaries are GL 4.1 (or ARB_get_program_binary), so are looked up at runtime:
+struct ProgramBinaryFunctions {
+	PFNGLGETPROGRAMBINARYPROC GetProgramBinary = nullptr;
+	PFNGLPROGRAMBINARYPROC ProgramBinary = nullptr;
+	PFNGLPROGRAMPARAMETERIPROC ProgramParameteri = nullptr;
+	std::string driver; //vendor/renderer/version, part of every cache key
+	bool available = false;
+
+	ProgramBinaryFunctions() {
+		auto get_string = [](GLenum name) -> std::string {
+			GLubyte const *str = glGetString(name);
+			return (str ? reinterpret_cast< char const * >(str) : "");
+		};
+		driver = get_string(GL_VENDOR) + "\n" + get_string(GL_RENDERER) + "\n" + get_string(GL_VERSION);
+
+		if (std::getenv("NO_PROGRAM_CACHE")) return;
+
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		while (glGetError() != GL_NO_ERROR) { } //(older drivers may not know the enum)
+		if (formats <= 0) return;
+
+		GetProgramBinary = reinterpret_cast< PFNGLGETPROGRAMBINARYPROC >(SDL_GL_GetProcAddress("glGetProgramBinary"));
+		ProgramBinary = reinterpret_cast< PFNGLPROGRAMBINARYPROC >(SDL_GL_GetProcAddress("glProgramBinary"));
+		ProgramParameteri = reinterpret_cast< PFNGLPROGRAMPARAMETERIPROC >(SDL_GL_GetProcAddress("glProgramParameteri"));
+		available = (GetProgramBinary && ProgramBinary && ProgramParameteri);
+	}
+};
+
+static ProgramBinaryFunctions &program_binary() {
+	static ProgramBinaryFunctions functions; //(first use is after the GL context exists)
+	return functions;
+}
+
+static uint64_t hash_strings(std::vector< std::string const * > const &strings) {
+	uint64_t hash = 0xcbf29ce484222325ULL; //FNV-1a
+	for (auto const *str : strings) {
+		for (char c : *str) {
+			hash = (hash ^ uint8_t(c)) * 0x100000001b3ULL;
+		}
+		hash = (hash ^ 0xff) * 0x100000001b3ULL; //separator, so ("ab","c") != ("a","bc")
+	}
+	return hash;
+}
+
+static std::string cache_filename(uint64_t key) {
+	char hex[17];
+	for (uint32_t i = 0; i < 16; ++i) {
+		hex[i] = "0123456789abcdef"[(key >> (60 - 4 * i)) & 0xf];
+	}
+	hex[16] = '\0';
+	return data_path("shader_cache/" + std::string(hex) + ".bin");
+}
+
+static bool link_succeeded(GLuint program) {
+	GLint link_status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+	return link_status == GL_TRUE;
+}
+
+//try to make 'program' from a cached binary; returns false (leaving 'program' unlinked) on any problem:
+static bool load_cached_program(GLuint program, uint64_t key, float *compile_ms) {
+	std::ifstream file(cache_filename(key), std::ios::binary);
+	if (!file) return false;
+
+	char magic[4];
+	uint64_t file_key = 0;
+	uint32_t format = 0;
+	uint32_t size = 0;
+	if (!file.read(magic, 4)
+	 || !file.read(reinterpret_cast< char * >(&file_key), sizeof(file_key))
+	 || !file.read(reinterpret_cast< char * >(&format), sizeof(format))
+	 || !file.read(reinterpret_cast< char * >(compile_ms), sizeof(*compile_ms))
+	 || !file.read(reinterpret_cast< char * >(&size), sizeof(size))) {
+		return false;
+	}
+	if (std::memcmp(magic, "pbc0", 4) != 0 || file_key != key || size == 0) return false;
+
+	std::vector< char > binary(size);
+	if (!file.read(binary.data(), size)) return false;
+
+	program_binary().ProgramBinary(program, format, binary.data(), GLsizei(size));
+	//(the driver may reject the binary -- e.g., after an update that didn't change the version string)
+	bool ok = link_succeeded(program);
+	while (glGetError() != GL_NO_ERROR) { }
+	return ok;
+}
+
+static void save_cached_program(GLuint program, uint64_t key, float compile_ms) {
+	GLint size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0) return;
+	std::vector< char > binary(size);
+	GLsizei length = 0;
+	GLenum format = 0;
+	program_binary().GetProgramBinary(program, size, &length, &format, binary.data());
+	if (length <= 0) return;
+
+	std::string dir = data_path("shader_cache");
+#ifdef _WIN32
+	_mkdir(dir.c_str());
+#else
+	mkdir(dir.c_str(), 0755);
+#endif
+
+	std::ofstream file(cache_filename(key), std::ios::binary);
+	if (!file) {
+		std::cerr << "Note: couldn't write program cache to '" << dir << "'." << std::endl;
+		return;
+	}
+	uint32_t format32 = format;
+	uint32_t size32 = uint32_t(length);
+	file.write("pbc0", 4);
+	file.write(reinterpret_cast< char const * >(&key), sizeof(key));
+	file.write(reinterpret_cast< char const * >(&format32), sizeof(format32));
+	file.write(reinterpret_cast< char const * >(&compile_ms), sizeof(compile_ms));
+	file.write(reinterpret_cast< char const * >(&size32), sizeof(size32));
+	file.write(binary.data(), length);
+}
+
+//------------------------------------------
+
 GLuint compile_program(
 	std::string const &vertex_shader_source,
 	std::string const &fragment_shader_source
 	) {
+	return compile_program(vertex_shader_source, fragment_shader_source, std::vector< std::string >());
+}
+
+GLuint compile_program(
+	std::string const &vertex_shader_source,
+	std::string const &fragment_shader_source,
+	std::vector< std::string > const &feedback_varyings
+	) {
+
+	auto before = std::chrono::high_resolution_clock::now();
+	auto ms_since = [](std::chrono::high_resolution_clock::time_point const &then) {
+		return std::chrono::duration< float, std::milli >(std::chrono::high_resolution_clock::now() - then).count();
+	};
+
+	GLuint program = glCreateProgram();
+
+	ProgramBinaryFunctions &binary = program_binary();
+	uint64_t key = 0;
+	if (binary.available) {
+		//(feedback varyings are part of the linked program, so they are part of the key)
+		std::string varyings;
+		for (auto const &varying : feedback_varyings) {
+			varyings += varying + "\n";
+		}
+		key = hash_strings({&vertex_shader_source, &fragment_shader_source, &varyings, &binary.driver});
+		float compile_ms = 0.0f;
+		if (load_cached_program(program, key, &compile_ms)) {
+			float load_ms = ms_since(before);
+			program_cache_stats.cached += 1;
+			program_cache_stats.load_ms += load_ms;
+			program_cache_stats.saved_ms += compile_ms - load_ms;
+			return program;
+		}
+		//(a failed glProgramBinary leaves the program object usable for a normal link)
+		binary.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 
 	GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
 	GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
 
-	GLuint program = glCreateProgram();
 	glAttachShader(program, vertex_shader);
 	glAttachShader(program, fragment_shader);
 
@@ -43,11 +226,17 @@ GLuint compile_program(
 	glDeleteShader(vertex_shader);
 	glDeleteShader(fragment_shader);
 
+	if (!feedback_varyings.empty()) {
+		std::vector< GLchar const * > names;
+		for (auto const &varying : feedback_varyings) {
+			names.emplace_back(varying.c_str());
+		}
+		glTransformFeedbackVaryings(program, GLsizei(names.size()), names.data(), GL_INTERLEAVED_ATTRIBS);
+	}
+
 	//link the shader program and throw errors if linking fails:
 	glLinkProgram(program);
-	GLint link_status = GL_FALSE;
-	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
-	if (link_status != GL_TRUE) {
+	if (!link_succeeded(program)) {
 		std::cerr << "Failed to link shader program." << std::endl;
 		GLint info_log_length = 0;
 		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_log_length);
@@ -58,5 +247,13 @@ GLuint compile_program(
 		throw std::runtime_error("failed to link program");
 	}
 
+	float compile_ms = ms_since(before);
+	program_cache_stats.compiled += 1;
+	program_cache_stats.compile_ms += compile_ms;
+
+	if (binary.available) {
+		save_cached_program(program, key, compile_ms);
+	}
+
 	return program;
 }
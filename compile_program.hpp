@@ -3,9 +3,29 @@
 #include "GL.hpp"
 
 #include <string>
+#include <vector>
 
 //compiles+links an OpenGL shader program from source.
 // throws on compilation error.
+//
+//Linked programs are cached on disk (as program binaries, where the driver supports them)
+// and reloaded from there on later runs; set NO_PROGRAM_CACHE in the environment to always compile.
 GLuint compile_program(
 	std::string const &vertex_shader_source,
 	std::string const &fragment_shader_source);
+
+//as above, but first sets the vertex shader outputs that transform feedback captures (interleaved, in order):
+GLuint compile_program(
+	std::string const &vertex_shader_source,
+	std::string const &fragment_shader_source,
+	std::vector< std::string > const &feedback_varyings);
+
+//how much time compile_program has spent (and saved) so far:
+struct ProgramCacheStats {
+	uint32_t compiled = 0; //programs compiled from source
+	uint32_t cached = 0; //programs loaded from the cache
+	float compile_ms = 0.0f; //time spent compiling
+	float load_ms = 0.0f; //time spent loading cached programs
+	float saved_ms = 0.0f; //(compile time recorded in the cache) - (time to load), summed over cached programs
+};
+extern ProgramCacheStats program_cache_stats;
@@ -5,8 +5,7 @@ struct DepthProgram {
 	//opengl program object:
 	GLuint program = 0;
 
-	//uniform locations:
-	GLuint object_to_clip_mat4 = -1U;
+	//uniforms: the "Object" block (see uniform_blocks.hpp)
 
 	DepthProgram();
 };
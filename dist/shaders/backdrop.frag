@@ -0,0 +1,8 @@
+#version 330
+//stretches the menu backdrop (a small, blurred copy of the screen; see MenuMode.cpp) over the screen:
+uniform sampler2D backdrop_tex;
+uniform vec2 dst_size;
+out vec4 fragColor;
+void main() {
+	fragColor = vec4(texture(backdrop_tex, gl_FragCoord.xy / dst_size).rgb, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 330
+//gaussian kernels with taps placed between texels, so bilinear filtering does half the work:
+// wide: 9-tap [1 8 28 56 70 56 28 8 1]/256 in 5 fetches; narrow: 5-tap [1 4 6 4 1]/16 in 3 fetches
+uniform sampler2D src_tex;
+uniform vec2 dst_size;
+uniform vec2 direction;
+uniform bool wide;
+out vec4 fragColor;
+void main() {
+	vec2 at = gl_FragCoord.xy / dst_size;
+	vec2 step = direction / vec2(textureSize(src_tex, 0));
+	vec3 c;
+	if (wide) {
+		c = 0.2270270270 * texture(src_tex, at).rgb
+		  + 0.3162162162 * (texture(src_tex, at + 1.3846153846 * step).rgb + texture(src_tex, at - 1.3846153846 * step).rgb)
+		  + 0.0702702703 * (texture(src_tex, at + 3.2307692308 * step).rgb + texture(src_tex, at - 3.2307692308 * step).rgb);
+	} else {
+		c = 0.375 * texture(src_tex, at).rgb
+		  + 0.3125 * (texture(src_tex, at + 1.2 * step).rgb + texture(src_tex, at - 1.2 * step).rgb);
+	}
+	fragColor = vec4(c, 1.0);
+}
@@ -0,0 +1,11 @@
+#version 330
+//(drawn with additive blending on top of the already-copied scene)
+uniform sampler2D bloom_tex;
+uniform vec2 dst_size;
+uniform vec2 src_scale; //part of bloom_tex the scene covers (less than 1 when drawn at reduced resolution)
+uniform float intensity;
+out vec4 fragColor;
+void main() {
+	vec3 bloom = texture(bloom_tex, gl_FragCoord.xy / dst_size * src_scale).rgb;
+	fragColor = vec4(intensity * bloom, 0.0);
+}
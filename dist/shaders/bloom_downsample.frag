@@ -0,0 +1,17 @@
+#version 330
+//four bilinear taps one source texel out from the center average a 4x4 block of source texels:
+uniform sampler2D src_tex;
+uniform vec2 dst_size;
+uniform float threshold;
+out vec4 fragColor;
+void main() {
+	vec2 at = gl_FragCoord.xy / dst_size;
+	vec2 px = 1.0 / vec2(textureSize(src_tex, 0));
+	vec3 c = 0.25 * (
+		  texture(src_tex, at + vec2(-px.x,-px.y)).rgb
+		+ texture(src_tex, at + vec2( px.x,-px.y)).rgb
+		+ texture(src_tex, at + vec2(-px.x, px.y)).rgb
+		+ texture(src_tex, at + vec2( px.x, px.y)).rgb
+	);
+	fragColor = vec4(max(c - vec3(threshold), vec3(0.0)), 1.0);
+}
@@ -0,0 +1,8 @@
+#version 330
+//(drawn with additive blending)
+uniform sampler2D src_tex;
+uniform vec2 dst_size;
+out vec4 fragColor;
+void main() {
+	fragColor = vec4(texture(src_tex, gl_FragCoord.xy / dst_size).rgb, 1.0);
+}
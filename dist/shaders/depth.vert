@@ -0,0 +1,9 @@
+#version 330
+#include "object_block.glsl"
+layout(location=0) in vec4 Position; //note: layout keyword used to make sure that the location-0 attribute is always bound to something
+in vec3 Normal; //DEBUG
+out vec3 color; //DEBUG
+void main() {
+	gl_Position = object_to_clip * Position;
+	color = 0.5 + 0.5 * Normal; //DEBUG
+}
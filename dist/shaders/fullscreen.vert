@@ -0,0 +1,5 @@
+#version 330
+//this draws a triangle that covers the entire screen (used by the bloom passes and the menu backdrop):
+void main() {
+	gl_Position = vec4(4 * (gl_VertexID & 1) - 1,  2 * (gl_VertexID & 2) - 1, 0.0, 1.0);
+}
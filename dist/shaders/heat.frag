@@ -0,0 +1,17 @@
+#version 330
+in vec2 position;
+uniform float top;
+uniform float bottom;
+uniform float time;
+out vec4 fragColor;
+void main() {
+//   vec2 position = gl_FragCoord.xy;
+   float mod = sin(cos(time) * 2 + position.x * 0.5f) * cos(time);
+   if (position.y > top + mod || position.y < bottom + mod) {
+       float distortion = sin(time * 4 + position.y * 0.5f);
+       float color = cos(distortion + position.x * 0.2f);
+	    fragColor = vec4(0.9f + color * 0.1f, 0.1f - color * 0.05f, 0.0, 0.2);
+   } else {
+       fragColor = vec4(0.0);
+   }
+}
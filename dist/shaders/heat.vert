@@ -0,0 +1,15 @@
+#version 330
+//this draws a triangle that covers the entire screen:
+//uniform float top;
+//uniform float bottom;
+uniform mat4 cam_scale;
+out vec2 position;
+void main() {
+//	if (gl_VertexID < 4) {
+//		gl_Position = cam_scale * vec4(100 * (2 * (gl_VertexID & 1) - 1), 100 * (gl_VertexID & 2) + top, 0.5, 1.0);
+//	} else if(gl_VertexID>=4){
+//		gl_Position = cam_scale * vec4(100 * (2 * (gl_VertexID & 1) - 1), -100 * (gl_VertexID & 2) + bottom, 0.5, 1.0);
+//	}
+   position = vec2(100 * (2 * (gl_VertexID & 1) - 1),  100 * (gl_VertexID & 2) - 100);
+   gl_Position = cam_scale * vec4(position, 0.5, 1.0);
+}
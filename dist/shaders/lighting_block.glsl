@@ -0,0 +1,12 @@
+//per-frame lighting block (mirrors LightingBlock in uniform_blocks.hpp):
+layout(std140) uniform Lighting {
+	vec3 sun_direction;
+	vec3 sun_color;
+	vec3 sky_direction;
+	vec3 sky_color;
+	vec3 spot_position;
+	vec3 spot_direction;
+	vec3 spot_color;
+	vec2 spot_outer_inner;
+	mat4 light_to_spot;
+};
@@ -0,0 +1,6 @@
+#version 330
+uniform vec3 color;
+out vec4 fragColor;
+void main() {
+	fragColor = vec4(color, 1.0);
+}
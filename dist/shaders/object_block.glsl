@@ -0,0 +1,7 @@
+//per-object block (mirrors ObjectBlock in uniform_blocks.hpp):
+layout(std140) uniform Object {
+	mat4 object_to_clip;
+	mat4x3 object_to_light;
+	mat3 normal_to_light;
+	float glow_amt;
+};
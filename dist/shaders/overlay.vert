@@ -0,0 +1,10 @@
+#version 330
+//2D overlay geometry (see draw_overlay.hpp), streamed from a StreamBuffer every frame:
+uniform mat4 mvp;
+layout(location=0) in vec2 Position;
+layout(location=1) in vec4 Color;
+out vec4 color;
+void main() {
+	gl_Position = mvp * vec4(Position, 0.0, 1.0);
+	color = Color;
+}
@@ -0,0 +1,12 @@
+#version 330
+in vec4 color;
+in vec2 corner;
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec4 bloomColor;
+void main() {
+	//soft round sprite:
+	float r2 = dot(corner, corner);
+	if (r2 > 1.0) discard;
+	fragColor = vec4(color.rgb, color.a * (1.0 - r2));
+	bloomColor = vec4(0.0); //(zero alpha, so blending leaves the glow buffer alone)
+}
@@ -0,0 +1,23 @@
+#version 330
+//draws each particle as a camera-facing quad (instanced; gl_VertexID picks the corner of a 4-vertex strip)
+uniform mat4 world_to_clip;
+uniform vec3 right; //camera's right and up directions in world space
+uniform vec3 up;
+layout(location=0) in vec4 PositionLife;
+layout(location=2) in vec4 Color;
+layout(location=3) in vec4 SizeGrowthDragLifespan;
+out vec4 color;
+out vec2 corner;
+void main() {
+	corner = vec2(2 * (gl_VertexID & 1) - 1, (gl_VertexID & 2) - 1);
+	if (PositionLife.w <= 0.0) {
+		//dead particle: put the quad outside the clip volume
+		gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+		color = vec4(0.0);
+		return;
+	}
+	float fade = clamp(PositionLife.w / SizeGrowthDragLifespan.w, 0.0, 1.0);
+	vec3 at = PositionLife.xyz + SizeGrowthDragLifespan.x * (corner.x * right + corner.y * up);
+	gl_Position = world_to_clip * vec4(at, 1.0);
+	color = vec4(Color.rgb, Color.a * fade);
+}
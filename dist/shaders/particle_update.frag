@@ -0,0 +1,6 @@
+#version 330
+//(never runs -- particle_update.vert is drawn with GL_RASTERIZER_DISCARD -- but programs need a fragment shader)
+out vec4 fragColor;
+void main() {
+	fragColor = vec4(0.0);
+}
@@ -0,0 +1,26 @@
+#version 330
+//advances every particle by 'elapsed' seconds; run with GL_RASTERIZER_DISCARD, outputs captured by transform feedback
+// (layout mirrors ParticleSystem::Particle)
+uniform float elapsed;
+layout(location=0) in vec4 PositionLife; //xyz: position, w: seconds left to live
+layout(location=1) in vec4 VelocityGravity; //xyz: velocity, w: acceleration along y
+layout(location=2) in vec4 Color;
+layout(location=3) in vec4 SizeGrowthDragLifespan; //x: radius, y: radius growth per second, z: drag, w: total lifespan
+out vec4 position_life;
+out vec4 velocity_gravity;
+out vec4 color;
+out vec4 size_growth_drag_lifespan;
+void main() {
+	position_life = PositionLife;
+	velocity_gravity = VelocityGravity;
+	color = Color;
+	size_growth_drag_lifespan = SizeGrowthDragLifespan;
+	if (PositionLife.w > 0.0) {
+		vec3 velocity = VelocityGravity.xyz;
+		velocity.y += VelocityGravity.w * elapsed;
+		velocity *= max(0.0, 1.0 - SizeGrowthDragLifespan.z * elapsed);
+		position_life = vec4(PositionLife.xyz + velocity * elapsed, PositionLife.w - elapsed);
+		velocity_gravity.xyz = velocity;
+		size_growth_drag_lifespan.x = max(0.0, SizeGrowthDragLifespan.x + SizeGrowthDragLifespan.y * elapsed);
+	}
+}
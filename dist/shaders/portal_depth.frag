@@ -0,0 +1,5 @@
+#version 330
+out vec4 fragColor;
+void main() {
+	fragColor = vec4(0.0, 1.0, 0.0, 0.0);
+}
@@ -0,0 +1,20 @@
+#version 330
+//this draws a triangle that covers the entire screen:
+uniform vec2 portalNorm;
+uniform mat4 mv;
+uniform mat4 cam_scale;
+void main() {
+//	gl_Position = vec4(4 * (gl_VertexID & 1) - 1,  2 * (gl_VertexID & 2) - 1, -1.0, 1.0);
+	if (gl_VertexID < 4) { // Clipping plane 1 (through portal)
+		vec4 pt = vec4(100000 * (2 * (gl_VertexID & 1) - 1), 0.0, 100000 * ((gl_VertexID & 2) - 1), 1.0);
+		gl_Position = cam_scale * mv * pt;
+	} else {
+		int idx = gl_VertexID - 4;
+		vec2 pt = vec2(mv * vec4(0.0, 0.0, 0.0, 1.0)) - portalNorm * 2.5;
+   	vec2 par = vec2(-portalNorm.y, portalNorm.x) * 1000.0;
+   	vec2 norm = portalNorm * 1000.0;
+   	pt = pt - norm * (idx & 1) + par * ((idx & 2) - 1);
+		gl_Position = cam_scale * vec4(pt, -1.0, 1.0);
+		gl_Position.z = -1.0;
+	}
+}
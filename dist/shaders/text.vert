@@ -0,0 +1,6 @@
+#version 330
+uniform mat4 mvp;
+in vec4 Position;
+void main() {
+	gl_Position = mvp * Position;
+}
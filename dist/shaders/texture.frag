@@ -0,0 +1,37 @@
+#version 330
+#include "object_block.glsl"
+#include "lighting_block.glsl"
+uniform sampler2D tex;
+uniform sampler2DShadow spot_depth_tex;
+in vec3 position;
+in vec3 normal;
+in vec4 color;
+in vec2 texCoord;
+in vec4 spotPosition;
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec4 bloomColor;
+void main() {
+	vec3 total_light = vec3(0.0, 0.0, 0.0);
+	vec3 n = normalize(normal);
+	{ //sky (hemisphere) light:
+		vec3 l = sky_direction;
+		float nl = 0.5 + 0.5 * dot(n,l);
+		total_light += nl * sky_color;
+	}
+	{ //sun (directional) light:
+		vec3 l = sun_direction;
+		float nl = max(0.0, dot(n,l));
+		total_light += nl * sun_color;
+	}
+	{ //spot (point with fov + shadow map) light:
+		vec3 l = normalize(spot_position - position);
+		float nl = max(0.0, dot(n,l));
+		float d = dot(l,-spot_direction);
+		float amt = smoothstep(spot_outer_inner.x, spot_outer_inner.y, d);
+		float shadow = textureProj(spot_depth_tex, spotPosition);
+		total_light += shadow * nl * amt * spot_color;
+	}
+	fragColor = texture(tex, texCoord) * vec4(color.rgb * 1.08f*total_light, color.a);
+	bloomColor = vec4(glow_amt*fragColor.rgb, 1.0);
+	//fragColor = vec4(vec3(gl_FragCoord.z), 1.0);
+}
@@ -0,0 +1,20 @@
+#version 330
+#include "object_block.glsl"
+#include "lighting_block.glsl"
+layout(location=0) in vec4 Position; //note: layout keyword used to make sure that the location-0 attribute is always bound to something
+in vec3 Normal;
+in vec4 Color;
+in vec2 TexCoord;
+out vec3 position;
+out vec3 normal;
+out vec4 color;
+out vec2 texCoord;
+out vec4 spotPosition;
+void main() {
+	gl_Position = object_to_clip * Position;
+	position = object_to_light * Position;
+	spotPosition = light_to_spot * vec4(position, 1.0);
+	normal = normal_to_light * Normal;
+	color = Color;
+	texCoord = TexCoord;
+}
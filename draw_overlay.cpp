@@ -0,0 +1,84 @@
+#include "draw_overlay.hpp"
+
+#include "GL.hpp"
+#include "Load.hpp"
+#include "shader_files.hpp"
+#include "gl_errors.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstddef>
+
+//------------ resources ------------
+
+StreamBuffer &overlay_stream() {
+	//a few thousand vertices per frame; like Load<>'ed resources, this lives until the program exits:
+	static StreamBuffer *stream = new StreamBuffer(64 * 1024);
+	return *stream;
+}
+
+//Uniform locations in overlay_program:
+GLint overlay_program_mvp_mat4 = -1;
+
+Load< GLuint > overlay_program(LoadTagInit, [](){
+	GLuint *ret = new GLuint(0);
+	//sources: dist/shaders/overlay.vert, overlay.frag
+	load_program_files(ret, "overlay.vert", "overlay.frag", [](GLuint program){
+		overlay_program_mvp_mat4 = glGetUniformLocation(program, "mvp");
+	});
+	return ret;
+});
+
+//Binding for using overlay_program on overlay_stream() (attribute locations are fixed in overlay.vert):
+Load< GLuint > overlay_stream_for_overlay_program(LoadTagDefault, [](){
+	GLuint vao = 0;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, overlay_stream().buffer);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(OverlayVertex), (GLbyte *)0 + offsetof(OverlayVertex, Position));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(OverlayVertex), (GLbyte *)0 + offsetof(OverlayVertex, Color));
+	glEnableVertexAttribArray(1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	GL_ERRORS();
+	return new GLuint(vao);
+});
+
+//----------------------
+
+void add_overlay_rect(std::vector< OverlayVertex > *vertices, glm::vec2 const &min, glm::vec2 const &max, glm::u8vec4 const &color) {
+	auto add = [&](float x, float y) {
+		OverlayVertex v;
+		v.Position = glm::vec2(x, y);
+		v.Color = color;
+		vertices->emplace_back(v);
+	};
+	add(min.x, min.y); add(max.x, min.y); add(max.x, max.y);
+	add(min.x, min.y); add(max.x, max.y); add(min.x, max.y);
+}
+
+void draw_overlay(std::vector< OverlayVertex > const &triangles) {
+	if (triangles.empty()) return;
+
+	GLintptr offset = overlay_stream().write(triangles.data(), GLsizeiptr(triangles.size() * sizeof(OverlayVertex)), sizeof(OverlayVertex));
+	if (offset < 0) return;
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	float aspect = viewport[2] / float(viewport[3]);
+	glm::mat4 mvp = glm::mat4(
+		1.0f / aspect, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f
+	);
+
+	glUseProgram(*overlay_program);
+	glUniformMatrix4fv(overlay_program_mvp_mat4, 1, GL_FALSE, glm::value_ptr(mvp));
+	glBindVertexArray(*overlay_stream_for_overlay_program);
+	//(the vertex array points at the start of the buffer; 'first' selects this frame's vertices)
+	glDrawArrays(GL_TRIANGLES, GLint(offset / GLintptr(sizeof(OverlayVertex))), GLsizei(triangles.size()));
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
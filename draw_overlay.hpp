@@ -0,0 +1,26 @@
+#pragma once
+
+#include "StreamBuffer.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+//Helper functions to draw flat-colored 2D geometry (meters, bars, markers) over the scene:
+// vertices are uploaded through overlay_stream() every call, so build them fresh every frame.
+
+struct OverlayVertex {
+	glm::vec2 Position;
+	glm::u8vec4 Color;
+};
+static_assert(sizeof(OverlayVertex) == 4*2 + 1*4, "OverlayVertex is packed.");
+
+//append a rectangle (as two triangles) to 'vertices':
+void add_overlay_rect(std::vector< OverlayVertex > *vertices, glm::vec2 const &min, glm::vec2 const &max, glm::u8vec4 const &color);
+
+//draw triangles, relative to a [-aspect,aspect]x[-1,1] screen (like draw_text):
+void draw_overlay(std::vector< OverlayVertex > const &triangles);
+
+//the buffer draw_overlay streams vertices through (created on first use);
+// main.cpp calls overlay_stream().next_frame() after each frame is drawn:
+StreamBuffer &overlay_stream();
@@ -4,7 +4,7 @@
 #include "Load.hpp"
 #include "MeshBuffer.hpp"
 #include "data_path.hpp"
-#include "compile_program.hpp"
+#include "shader_files.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
@@ -32,25 +32,12 @@ GLint text_program_mvp_mat4 = -1;
 GLint text_program_color_vec4 = -1;
 
 Load< GLuint > text_program(LoadTagInit, [](){
-	GLuint *ret = new GLuint(compile_program(
-		"#version 330\n"
-		"uniform mat4 mvp;\n"
-		"in vec4 Position;\n"
-		"void main() {\n"
-		"	gl_Position = mvp * Position;\n"
-		"}\n"
-	,
-		"#version 330\n"
-		"uniform vec4 color;\n"
-		"out vec4 fragColor;\n"
-		"void main() {\n"
-		"	fragColor = color;\n"
-		"}\n"
-	));
-
-	text_program_mvp_mat4 = glGetUniformLocation(*ret, "mvp");
-	text_program_color_vec4 = glGetUniformLocation(*ret, "color");
-
+	GLuint *ret = new GLuint(0);
+	//sources: dist/shaders/text.vert, text.frag
+	load_program_files(ret, "text.vert", "text.frag", [](GLuint program){
+		text_program_mvp_mat4 = glGetUniformLocation(program, "mvp");
+		text_program_color_vec4 = glGetUniformLocation(program, "color");
+	});
 	return ret;
 });
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+//GPUTimer measures how long the GPU spends on the commands between begin() and end(),
+// using GL_TIME_ELAPSED queries. Results arrive a few frames late, so a small ring of
+// queries is kept in flight and results are only read once they are available (never stalls).
+//NOTE: GL_TIME_ELAPSED queries can't be nested, so timed sections must not overlap.
+//
+//Set the GPU_TIMERS environment variable to print averages every 'ReportInterval' samples.
+//
+//Usage:
+//  static GPUTimer timer("bloom");
+//  timer.begin();
+//  ...draw...
+//  timer.end();
+struct GPUTimer {
+	GPUTimer(std::string const &name_) : name(name_), report(std::getenv("GPU_TIMERS") != nullptr) { }
+	~GPUTimer() {
+		if (queries[0] != 0) glDeleteQueries(Ring, queries);
+	}
+
+	void begin() {
+		if (queries[0] == 0) glGenQueries(Ring, queries);
+		collect();
+		//all queries still in flight? skip timing this time around:
+		if (pending[next]) return;
+		glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+		active = true;
+	}
+
+	void end() {
+		if (!active) return;
+		glEndQuery(GL_TIME_ELAPSED);
+		pending[next] = true;
+		next = (next + 1) % Ring;
+		active = false;
+	}
+
+	//read back any finished queries:
+	void collect() {
+		for (uint32_t i = 0; i < Ring; ++i) {
+			if (!pending[i]) continue;
+			GLuint available = 0;
+			glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) continue;
+			GLuint ns = 0;
+			glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT, &ns);
+			pending[i] = false;
+
+			last_ms = ns / 1.0e6f;
+			results += 1;
+			total_ms += last_ms;
+			samples += 1;
+			if (samples == ReportInterval) {
+				average_ms = total_ms / samples;
+				if (report) {
+					std::cout << "[gpu] " << name << ": " << average_ms << "ms (average of " << samples << " frames)" << std::endl;
+				}
+				total_ms = 0.0f;
+				samples = 0;
+			}
+		}
+	}
+
+	std::string name;
+	bool report;
+
+	float last_ms = 0.0f; //most recent result
+	uint32_t results = 0; //results collected so far (changes whenever last_ms is updated)
+	float average_ms = 0.0f; //average over the last full reporting interval
+
+	//internals:
+	static constexpr uint32_t Ring = 4;
+	static constexpr uint32_t ReportInterval = 120;
+	GLuint queries[Ring] = {0, 0, 0, 0};
+	bool pending[Ring] = {false, false, false, false};
+	uint32_t next = 0;
+	bool active = false;
+	float total_ms = 0.0f;
+	uint32_t samples = 0;
+};
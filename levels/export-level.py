@@ -0,0 +1,162 @@
+#!/usr/bin/env python
+
+#Note: unlike the scripts in meshes/, this doesn't need blender:
+#python export-level.py <level.py> <outfile.level>
+#
+#<level.py> is a python file that sets the variables described in the comments below
+# (see vegetables.py and oven.py for examples); the result is read by ScriptedLevel.cpp.
+
+import sys, struct, math
+
+if len(sys.argv) != 3:
+	print("\n\nUsage:\npython export-level.py <level.py> <outfile.level>\nConverts a level description to the chunked binary format ScriptedLevel reads.\n")
+	exit(1)
+
+infile = sys.argv[1]
+outfile = sys.argv[2]
+
+print("Will export level '" + infile + "' to '" + outfile + "'")
+
+level = dict()
+with open(infile, 'r') as f:
+	exec(f.read(), level)
+
+#Level file format (all chunks always present, in this order):
+# str0 len < char > * [strings]
+# lvl0 len < bgm(uint uint) prelude(uint uint) prelude_time(f) meshes(uint uint) start_score(int) win_hits(uint) time_limit(f) message_time(f) sky_color(3f) sky_direction(3f) > [one entry]
+# knd0 len < name(uint uint) > * [food kinds: mesh name, also the Object::data that pots match]
+# pot0 len < kind(uint) position(3f) > *
+# prp0 len < mesh(uint uint) texture(uint uint) position(3f) rotation(4f) scale(3f) food(uint) box(2f) > * [scenery, and foods placed at the start]
+# spn0 len < start interval x_min(3f) x_count(uint) y(f) table(uint uint) > * [spawn phases, by start time]
+# tbl0 len < kind(uint) > * [spawn tables; each kind repeated by its weight]
+# rul0 len < score(int) hits(uint) loses(uint) > * [one per event: pot_match, pot_mismatch, fall_off, in_band]
+# hot0 len < center amplitude frequency height rate max score_interval(7f) > [heat band; zero or one entry]
+# stg0 len < above(f) texture(uint uint) > * [heat stages, by 'above']
+# msg0 len < text(uint uint) y(f) height(f) > * [intro message lines]
+
+strings_data = b""
+
+#write_string will add a string to the strings section and return a packed (begin,end) reference:
+def write_string(string):
+	global strings_data
+	begin = len(strings_data)
+	strings_data += bytes(string, 'utf8')
+	end = len(strings_data)
+	return struct.pack('II', begin, end)
+
+kinds = []
+def kind_index(name):
+	if name not in kinds:
+		kinds.append(name)
+	return kinds.index(name)
+
+for name in level.get("foods", []):
+	kind_index(name)
+
+lvl_data = b""
+lvl_data += write_string(level.get("bgm", ""))
+lvl_data += write_string(level.get("prelude", ""))
+lvl_data += struct.pack('f', level.get("prelude_time", 0.0))
+lvl_data += write_string(level.get("meshes", "vegetables"))
+lvl_data += struct.pack('iIff', level.get("start_score", 0), level.get("win_hits", 0), level.get("time_limit", 0.0), level.get("message_time", 0.0))
+lvl_data += struct.pack('3f', *level.get("sky_color", (0.8, 0.8, 0.8)))
+lvl_data += struct.pack('3f', *level.get("sky_direction", (0.0, 0.0, 1.0)))
+
+pot_data = b""
+for pot in level.get("pots", []):
+	pot_data += struct.pack('I', kind_index(pot["accepts"]))
+	pot_data += struct.pack('3f', *pot["position"])
+
+#rotation is given as degrees around x, then y, then z; (x,y,z,w) quaternion is stored:
+def quaternion(degrees):
+	def axis_angle(axis, angle):
+		s = math.sin(math.radians(angle) / 2.0)
+		return (axis[0] * s, axis[1] * s, axis[2] * s, math.cos(math.radians(angle) / 2.0))
+	def multiply(a, b):
+		ax, ay, az, aw = a
+		bx, by, bz, bw = b
+		return (
+			aw*bx + ax*bw + ay*bz - az*by,
+			aw*by - ax*bz + ay*bw + az*bx,
+			aw*bz + ax*by - ay*bx + az*bw,
+			aw*bw - ax*bx - ay*by - az*bz)
+	q = axis_angle((1,0,0), degrees[0])
+	q = multiply(axis_angle((0,1,0), degrees[1]), q)
+	q = multiply(axis_angle((0,0,1), degrees[2]), q)
+	return q
+
+prp_data = b""
+for prop in level.get("props", []):
+	prp_data += write_string(prop["mesh"])
+	prp_data += write_string(prop.get("texture", "white"))
+	prp_data += struct.pack('3f', *prop.get("position", (0.0, 0.0, 0.0)))
+	#(meshes are exported lying down, so props stand them up by default)
+	prp_data += struct.pack('4f', *quaternion(prop.get("rotation", (-90.0, 0.0, 0.0))))
+	prp_data += struct.pack('3f', *prop.get("scale", (1.0, 1.0, 1.0)))
+	prp_data += struct.pack('I', 1 if prop.get("food", False) else 0)
+	prp_data += struct.pack('2f', *prop.get("box", (2.0, 2.0)))
+
+spn_data = b""
+tbl = []
+for spawn in sorted(level.get("spawns", []), key=lambda s: s["start"]):
+	x_min, x_max = spawn["x"]
+	assert(x_max > x_min)
+	begin = len(tbl)
+	for name, weight in spawn["foods"].items():
+		tbl += [kind_index(name)] * weight
+	assert(len(tbl) > begin)
+	spn_data += struct.pack('3fIf', spawn["start"], spawn["interval"], x_min, x_max - x_min, spawn["y"])
+	spn_data += struct.pack('II', begin, len(tbl))
+tbl_data = b"".join(struct.pack('I', k) for k in tbl)
+
+rul_data = b""
+for event in ["pot_match", "pot_mismatch", "fall_off", "in_band"]:
+	rule = level.get("rules", {}).get(event, (0, 0))
+	score, hits = rule[0], rule[1]
+	loses = len(rule) > 2 and rule[2] == "lose"
+	rul_data += struct.pack('iII', score, hits, 1 if loses else 0)
+
+hot_data = b""
+if "heat_band" in level:
+	band = level["heat_band"]
+	hot_data += struct.pack('7f', band["center"], band["amplitude"], band["frequency"], band["height"],
+		band["rate"], band.get("max", 100.0), band.get("score_interval", 1.0))
+
+stg_data = b""
+for above, texture in sorted(level.get("heat_stages", []), key=lambda s: s[0]):
+	stg_data += struct.pack('f', above)
+	stg_data += write_string(texture)
+
+msg_data = b""
+y = -0.3
+for message in level.get("messages", []):
+	msg_data += write_string(message)
+	msg_data += struct.pack('ff', y, 0.1)
+	y -= level.get("message_spacing", 0.15)
+
+#kinds are written last, since the sections above add to them:
+knd_data = b""
+for name in kinds:
+	knd_data += write_string(name)
+
+#write the chunks:
+def write_chunk(f, magic, data):
+	assert(len(magic) == 4)
+	f.write(struct.pack('4s', magic))
+	f.write(struct.pack('I', len(data)))
+	f.write(data)
+
+with open(outfile, 'wb') as f:
+	write_chunk(f, b'str0', strings_data)
+	write_chunk(f, b'lvl0', lvl_data)
+	write_chunk(f, b'knd0', knd_data)
+	write_chunk(f, b'pot0', pot_data)
+	write_chunk(f, b'prp0', prp_data)
+	write_chunk(f, b'spn0', spn_data)
+	write_chunk(f, b'tbl0', tbl_data)
+	write_chunk(f, b'rul0', rul_data)
+	write_chunk(f, b'hot0', hot_data)
+	write_chunk(f, b'stg0', stg_data)
+	write_chunk(f, b'msg0', msg_data)
+
+print("Wrote " + str(len(kinds)) + " food kinds, " + str(len(level.get("pots", []))) + " pots, " + str(len(level.get("props", []))) + " props.")
@@ -0,0 +1,37 @@
+#"Oven": keep the steak inside the band of safe heat for a minute without burning it.
+#(read by export-level.py; see ScriptedLevel.hpp for what each field means)
+
+meshes = "steakLevels"
+
+prelude = "sound_effects/taiko_initial_pipe.wav"
+prelude_time = 3.0
+bgm = "sound_effects/taiko_warrior_trimmed.wav"
+
+start_score = 0
+time_limit = 60.0
+
+message_time = 5.0
+messages = ["DONT BURN", "THE MEAT", "FOR 60 SECONDS"]
+message_spacing = 0.2
+
+#warm light from the oven:
+sky_color = (0.7, 0.6, 0.6)
+sky_direction = (-0.6, 0.5, 1.0)
+
+props = [
+	{ "mesh": "steak", "food": True, "box": (4.0, 4.0), "position": (0.0, 10.0, 0.0), "rotation": (0.0, -90.0, 0.0), "scale": (2.0, 2.0, 2.0) },
+	{ "mesh": "oven", "position": (0.0, 7.0, 0.0), "rotation": (0.0, -90.0, -90.0), "scale": (3.0, 7.5, 8.0) },
+]
+
+#the safe band is 40 units tall, its top swaying between -10 and 50 (starting at 20);
+# outside it the steak heats up by 10 per second, and burns past 100:
+heat_band = { "center": 20.0, "amplitude": 30.0, "frequency": 0.2, "height": 40.0, "rate": 10.0, "max": 100.0, "score_interval": 1.0 }
+
+#the steak darkens as it cooks:
+heat_stages = [ (10.0, "meat1"), (40.0, "meat2"), (60.0, "meat3"), (80.0, "meat4") ]
+
+#(score change, hits[, "lose"]) for each thing that can happen:
+rules = {
+	"fall_off": (0, 0, "lose"),
+	"in_band": (1, 0), #a point per second in the band
+}
@@ -0,0 +1,35 @@
+#"Vegetables": sort falling vegetables into the pot that matches each one.
+#(read by export-level.py; see ScriptedLevel.hpp for what each field means)
+
+bgm = "sound_effects/the_happy_song_full.wav"
+
+start_score = 50
+win_hits = 20
+
+message_time = 5.0
+messages = ["GET THE VEGETABLES", "INTO THE", "CORRECT POTS"]
+
+foods = ["Broccoli", "Potato", "Carrot", "Mushroom"]
+
+#pots along the bottom, each with a copy of the vegetable it wants floating in front of it:
+pots = [ { "accepts": food, "position": (35.0 * i - 50.0, -35.0, 0.0) } for i, food in enumerate(foods) ]
+
+props = [
+	{ "mesh": pot["accepts"], "position": (pot["position"][0], pot["position"][1], 10.0), "scale": (0.6, 0.6, 0.6) }
+	for pot in pots
+] + [
+	{ "mesh": "Table", "position": (0.0, -75.0, 5.1) },
+	{ "mesh": "bg", "texture": "kitchen", "scale": (0.8, 0.7, 0.7) },
+]
+
+#one vegetable every five seconds (the first right away), at a whole-number x in [-75, 75) across the top:
+spawns = [
+	{ "start": 0.0, "interval": 5.0, "x": (-75, 75), "y": 50.0, "foods": { food: 1 for food in foods } },
+]
+
+#(score change, hits[, "lose"]) for each thing that can happen to a food:
+rules = {
+	"pot_match": (10, 1),
+	"pot_mismatch": (-10, 0),
+	"fall_off": (-10, 0),
+}
@@ -7,6 +7,28 @@
 //The 'GameMode' mode plays the game:
 #include "GameMode.hpp"
 
+//InputRecord.hpp handles recording and replaying input:
+#include "InputRecord.hpp"
+
+//compile_program.hpp keeps track of time spent compiling (or loading cached) shaders:
+#include "compile_program.hpp"
+
+//shader_files.hpp rebuilds shader programs when their source files change:
+#include "shader_files.hpp"
+
+//SimulationThread.hpp runs updates alongside drawing; spsc_queue.hpp hands input over to it:
+#include "SimulationThread.hpp"
+#include "spsc_queue.hpp"
+
+//FramePacer.hpp limits queued frames and measures input latency:
+#include "FramePacer.hpp"
+
+//for finish_saves:
+#include "Save.hpp"
+
+//draw_overlay.hpp streams per-frame overlay geometry, which needs to know where frames end:
+#include "draw_overlay.hpp"
+
 //The 'Sound' header has functions for managing sound:
 #include "Sound.hpp"
 
@@ -28,9 +50,14 @@
 #include <fstream>
 #include <memory>
 #include <algorithm>
+#include <functional>
+#include <thread>
+#include <cstdlib>
+#include <limits>
 
 // Many mouse: multiple mice input
 #include "manymouse/manymouse.h"
+#include "MouseInput.hpp"
 
 //extern "C" int ManyMouse_Init();
 //extern "C" void ManyMouse_Quit();
@@ -55,6 +82,38 @@ int main(int argc, char **argv) {
 	Client client(argv[1], argv[2]);
 	*/
 
+	//----- command line options ----
+	std::string record_filename; //if non-empty, record input to this file
+	std::string replay_filename; //if non-empty, play back input from this file
+	bool headless = false; //when replaying, skip drawing and run as fast as possible
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--record" && i + 1 < argc) {
+			record_filename = argv[++i];
+		} else if (arg == "--replay" && i + 1 < argc) {
+			replay_filename = argv[++i];
+		} else if (arg == "--headless") {
+			headless = true;
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--record <file>] [--replay <file> [--headless]]" << std::endl;
+			return 1;
+		}
+	}
+	if (!record_filename.empty() && !replay_filename.empty()) {
+		std::cerr << "Can't record and replay at the same time." << std::endl;
+		return 1;
+	}
+	if (headless && replay_filename.empty()) {
+		std::cerr << "--headless only makes sense with --replay." << std::endl;
+		return 1;
+	}
+
+	std::unique_ptr< InputReplay > replay;
+	if (!replay_filename.empty()) {
+		replay.reset(new InputReplay(replay_filename));
+		config.size = replay->window_size;
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
@@ -80,6 +139,7 @@ int main(int argc, char **argv) {
 		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
 		config.size.x, config.size.y,
 		SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI
+		| (headless ? SDL_WINDOW_HIDDEN : 0)
 	);
 
 	//prevent exceedingly tiny windows when resizing:
@@ -104,13 +164,9 @@ int main(int argc, char **argv) {
 	init_gl_shims();
 	#endif
 
-	//Set VSYNC + Late Swap (prevents crazy FPS):
-	if (SDL_GL_SetSwapInterval(-1) != 0) {
-		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
-		if (SDL_GL_SetSwapInterval(1) != 0) {
-			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
-		}
-	}
+	//Set vsync (+ late swap tearing), and keep the CPU from queuing up frames ahead of the GPU:
+	//(see FramePacer.hpp for settings)
+	std::unique_ptr< FramePacer > pacer(new FramePacer());
 
 	//Hide mouse cursor (note: showing can be useful for debugging):
 	//SDL_ShowCursor(SDL_DISABLE);
@@ -119,33 +175,24 @@ int main(int argc, char **argv) {
 	Sound::init();
 
 	//------------ init manymouse ------------
-	int available_mice = ManyMouse_Init();
-
-    if (available_mice < 0)
-    {
-        printf("Error initializing ManyMouse!\n");
-    }
-
-    printf("ManyMouse driver: %s\n", ManyMouse_DriverName());
-
-    if (available_mice == 0)
-    {
-        printf("No mice detected!\n");
-    }
-
-    for (int i = 0; i < available_mice; i++)
-    {
-        const char *name = ManyMouse_DeviceName(i);
-        printf("#%d: %s\n", i, name);
-    }
+	//(on Linux, mice are read on their own thread, with kernel timestamps)
+	MouseInput mouse_input;
 
 	//------------ load assets --------------
 
-	call_load_functions();
+	{
+		auto before = std::chrono::high_resolution_clock::now();
+		call_load_functions();
+		double load_ms = std::chrono::duration< double, std::milli >(std::chrono::high_resolution_clock::now() - before).count();
+		std::cout << "Loaded assets in " << load_ms << "ms; shader programs: "
+			<< program_cache_stats.compiled << " compiled (" << program_cache_stats.compile_ms << "ms), "
+			<< program_cache_stats.cached << " from cache (" << program_cache_stats.load_ms << "ms, saving " << program_cache_stats.saved_ms << "ms)." << std::endl;
+	}
 
 	//------------ create game mode + make current --------------
 
 	auto gm = std::make_shared< GameMode >(/*client*/);
+	if (replay) gm->seed = replay->seed;
 	Mode::set_current(gm);
 	gm->load_scene();
 
@@ -167,53 +214,216 @@ int main(int argc, char **argv) {
 	};
 	on_resize();
 
-	//This will loop until the current mode is set to null:
-	while (Mode::current) {
-		//every pass through the game loop creates one frame of output
-		//  by performing three steps:
-
-		{ //(1) process any events that are pending
-			static SDL_Event evt;
-			while (SDL_PollEvent(&evt) == 1) {
-				//handle resizing:
-				if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-					on_resize();
-				}
-				//handle input:
-				if (Mode::current && Mode::current->handle_event(evt, window_size)) {
-					// mode handled it; great
-				} else if (evt.type == SDL_QUIT) {
-					Mode::set_current(nullptr);
-					break;
-				}
+	std::unique_ptr< InputRecorder > recorder;
+	if (!record_filename.empty()) {
+		recorder.reset(new InputRecorder(record_filename, gm->seed, window_size));
+	}
+	if (replay) {
+		//modes see the window size from the recording, not the actual window:
+		window_size = replay->window_size;
+	}
+
+	//headless replay statistics:
+	uint32_t replay_frames = 0;
+	uint32_t replay_ticks = 0;
+	double replay_update_time = 0.0;
+	double replay_worst_tick = 0.0;
+
+	//real time not yet simulated (always less than one Mode::Tick after the update step):
+	float tick_accumulator = 0.0f;
+
+	//input for the current frame (kept around to avoid re-allocating every frame):
+	InputFrame frame;
+	std::vector< double > mouse_times; //(as reported by MouseInput, before they're made relative to the frame)
+
+	//The simulation runs one frame behind drawing: while frame N is drawn from a copy of the mode's state
+	// (see Mode::capture_draw_state), the updates for frame N+1 run on the simulation thread.
+	//Modes that draw from their live state (menus) -- and headless replays, which don't draw -- run serially.
+	//set SERIAL_SIMULATION in the environment to always run serially.
+	bool pipelined = !headless && std::thread::hardware_concurrency() > 1 && !std::getenv("SERIAL_SIMULATION");
+	SimulationThread simulation(pipelined);
+
+	//input frames, handed from this thread to the simulation:
+	SPSCQueue< InputFrame, 4 > input_queue;
+
+	//only touched by 'simulate':
+	InputFrame sim_frame;
+	glm::uvec2 sim_window_size = window_size; //(modes see the recorded window size when replaying)
+
+	//handle one frame of queued input, then run as many update ticks as its elapsed time calls for:
+	std::function< void() > simulate = [&](){
+		if (!input_queue.pop(&sim_frame)) return;
+
+		for (auto const &evt : sim_frame.events) {
+			if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+				sim_window_size = glm::uvec2(evt.window.data1, evt.window.data2);
+			}
+			//handle input:
+			if (Mode::current && Mode::current->handle_event(evt, sim_window_size)) {
+				// mode handled it; great
+			} else if (evt.type == SDL_QUIT) {
+				Mode::set_current(nullptr);
+				break;
 			}
+		}
 
-			static ManyMouseEvent event;
-			while (ManyMouse_PollEvent(&event) != 0) {
+		//mouse events go to the mode just before the first tick that ends after they happened,
+		// so motion lands in the right tick rather than all at the start of the frame:
+		uint32_t next_mouse = 0;
+		auto handle_mouse_until = [&](float until) {
+			for (; next_mouse < sim_frame.mouse_events.size() && sim_frame.mouse_times[next_mouse] <= until; ++next_mouse) {
 				// handle mouse inputs
-				if (Mode::current && Mode::current->handle_mouse_event(event, window_size)) {
+				if (Mode::current && Mode::current->handle_mouse_event(sim_frame.mouse_events[next_mouse], sim_window_size)) {
 					// mode handled event
 				}
 			}
-
-			if (!Mode::current) break;
+		};
+
+		//(the same 'elapsed' values always give the same ticks, so replays stay exact)
+		float tick_end = -tick_accumulator; //end of the last tick, in seconds after the start of this frame
+		tick_accumulator += sim_frame.elapsed;
+		while (tick_accumulator >= Mode::Tick && Mode::current) {
+			tick_accumulator -= Mode::Tick;
+			tick_end += Mode::Tick;
+			handle_mouse_until(tick_end);
+			auto before = std::chrono::high_resolution_clock::now();
+			Mode::current->update(Mode::Tick);
+			if (headless) {
+				double tick_time = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+				replay_ticks += 1;
+				replay_update_time += tick_time;
+				replay_worst_tick = std::max(replay_worst_tick, tick_time);
+			}
 		}
+		handle_mouse_until(std::numeric_limits< float >::infinity()); //(the rest fall in the next tick)
+		Mode::tick_alpha = tick_accumulator / Mode::Tick;
+	};
+
+	//when the input behind each state was gathered (for FramePacer's latency measurement):
+	double input_time = 0.0; //this frame's input
+	double simulating_input_time = 0.0; //input being simulated (or last simulated)
+	double drawing_input_time = 0.0; //input reflected in what is being drawn
+
+	//apply any mouse mode change the game asked for (SDL mouse calls belong on this thread):
+	auto apply_mouse_mode = [&]() {
+		if (gm->wanted_mouse_mode == GameMode::MouseModeUnchanged) return;
+		SDL_SetRelativeMouseMode(gm->wanted_mouse_mode == GameMode::MouseModeRelative ? SDL_TRUE : SDL_FALSE);
+		gm->wanted_mouse_mode = GameMode::MouseModeUnchanged;
+	};
+
+	//level switches (GameMode::load_scene calls) seen so far, so the pacer can watch the frames around each one:
+	uint32_t seen_scene_loads = gm->scene_loads;
+	auto watch_level_switch = [&]() {
+		if (gm->scene_loads == seen_scene_loads) return;
+		seen_scene_loads = gm->scene_loads;
+		if (!headless) pacer->begin_transition();
+	};
+
+	//This will loop until the current mode is set to null:
+	//(Mode::current may be changed by the simulation thread, so it's only looked at once the simulation is done)
+	bool quit = false;
+	while (true) {
+		//wait (if needed) so input is gathered as late as possible before it's used:
+		if (!headless) pacer->begin_frame();
 
-		{ //(2) call the current mode's "update" function to deal with elapsed time:
-			auto current_time = std::chrono::high_resolution_clock::now();
-			static auto previous_time = current_time;
-			float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
-			previous_time = current_time;
+		//every pass through the game loop creates one frame of output
+		//  by performing four steps:
+
+		{ //(1) gather pending input and queue it for the simulation:
+			frame.events.clear();
+			frame.mouse_events.clear();
+			frame.mouse_times.clear();
+			input_time = MouseInput::now();
+
+			if (replay) {
+				//input comes from the recording, but still service the window:
+				SDL_Event evt;
+				while (SDL_PollEvent(&evt) == 1) {
+					if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+						on_resize();
+					} else if (evt.type == SDL_QUIT) {
+						quit = true;
+					}
+				}
+				if (!quit && !replay->read_frame(&frame)) {
+					std::cout << "Replay finished." << std::endl;
+					quit = true;
+				}
+			} else {
+				SDL_Event evt;
+				while (SDL_PollEvent(&evt) == 1) {
+					//handle resizing:
+					if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+						on_resize();
+					}
+					frame.events.emplace_back(evt);
+				}
+				mouse_input.poll(&frame.mouse_events, &mouse_times);
 
-			//if frames are taking a very long time to process,
-			//lag to avoid spiral of death:
-			elapsed = std::min(0.1f, elapsed);
+				auto current_time = std::chrono::high_resolution_clock::now();
+				static auto previous_time = current_time;
+				float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
+				previous_time = current_time;
 
-			Mode::current->update(elapsed);
+				//if frames are taking a very long time to process,
+				//lag to avoid spiral of death:
+				frame.elapsed = std::min(0.1f, elapsed);
+
+				//place mouse events within the frame (which ends now):
+				double frame_start = MouseInput::now() - frame.elapsed;
+				for (double time : mouse_times) {
+					frame.mouse_times.emplace_back(float(std::min(std::max(time - frame_start, 0.0), double(frame.elapsed))));
+				}
+				mouse_times.clear();
+
+				if (recorder) recorder->write_frame(frame);
+			}
+
+			if (!quit && !input_queue.push(frame)) {
+				throw std::runtime_error("Input queue overflowed (simulation fell more than a few frames behind).");
+			}
+		}
+
+		//(2) wait for the simulation of the previous frame's input:
+		simulation.finish();
+		apply_mouse_mode();
+		watch_level_switch();
+		if (quit) Mode::set_current(nullptr);
+		if (!Mode::current) break;
+
+		//(3) call the current mode's "update" function (via 'simulate') for this frame's input,
+		// alongside drawing the previous state if the mode allows it:
+		std::shared_ptr< Mode > drawing = Mode::current;
+		if (simulation.threaded && drawing->draws_from_capture()) {
+			drawing->capture_draw_state();
+			drawing_input_time = simulating_input_time;
+			simulating_input_time = input_time;
+			simulation.start(simulate);
+		} else {
+			simulating_input_time = drawing_input_time = input_time;
+			simulate();
+			apply_mouse_mode();
+			watch_level_switch();
+			if (headless) {
+				replay_frames += 1;
+				continue;
+			}
 			if (!Mode::current) break;
+			drawing = Mode::current;
+			drawing->capture_draw_state();
+
+			if (!drawing->needs_draw(drawable_size)) {
+				//the last frame shown is still right (e.g., a menu nobody is touching), so leave it up and wait for input:
+				// (with a timeout, so mouse input -- which doesn't come through SDL -- and ticks are still handled)
+				SDL_WaitEventTimeout(nullptr, 50);
+				continue;
+			}
 		}
 
-		{ //(3) call the current mode's "draw" function to produce output:
+		//pick up any edited shaders (between frames, so a frame never mixes old and new programs):
+		reload_changed_programs();
+
+		{ //(4) call the mode's "draw" function to produce output:
 			//clear the depth+color buffers and set some default state:
 			glClearColor(0.5, 0.5, 0.5, 0.0);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -221,24 +431,39 @@ int main(int argc, char **argv) {
 			glEnable(GL_BLEND);
 			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-			Mode::current->draw(drawable_size);
+			drawing->draw(drawable_size);
+
+			if (pacer->show_stats) pacer->draw_stats(drawable_size);
+
+			//fence this frame's streamed overlay vertices, and move on to the next part of the buffer:
+			overlay_stream().next_frame();
 		}
 
 		//Finally, wait until the recently-drawn frame is shown before doing it all again:
 		SDL_GL_SwapWindow(window);
+		pacer->end_frame(drawing_input_time);
 	}
+	simulation.finish();
 
+	if (headless && replay_ticks > 0) {
+		std::cout << "Replayed " << replay_frames << " frames (" << replay_ticks << " ticks); update took "
+			<< (replay_update_time / replay_ticks) * 1000.0 << "ms per tick on average, "
+			<< replay_worst_tick * 1000.0 << "ms at worst." << std::endl;
+	}
+
+	recorder.reset();
+	finish_saves(); //(saves are written on their own thread)
 
 	//------------  teardown ------------
 
+	pacer.reset(); //(deletes fences, so before the context goes)
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
 	SDL_DestroyWindow(window);
 	window = NULL;
 
-	ManyMouse_Quit();
-
 	return 0;
 
 #ifdef _WIN32
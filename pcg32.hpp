@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+//PCG32 is a small, fast random number generator (O'Neill's PCG, "XSH RR" output on a 64-bit LCG).
+//Its whole state is two 64-bit numbers, so it is cheap to copy into quicksaves and snapshots,
+// and generators with different 'stream' values give independent sequences from the same seed.
+//It meets the requirements of a UniformRandomBitGenerator, so std:: distributions work with it too.
+struct PCG32 {
+	typedef uint32_t result_type;
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return 0xffffffffU; }
+
+	PCG32() = default;
+	PCG32(uint64_t seed_, uint64_t stream = 0) { seed(seed_, stream); }
+
+	void seed(uint64_t seed_, uint64_t stream = 0) {
+		state = 0;
+		inc = (stream << 1) | 1; //(must be odd)
+		(*this)();
+		state += seed_;
+		(*this)();
+	}
+
+	uint32_t operator()() {
+		uint64_t old = state;
+		state = old * 6364136223846793005ULL + inc;
+		uint32_t xorshifted = uint32_t(((old >> 18) ^ old) >> 27);
+		uint32_t rot = uint32_t(old >> 59);
+		return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+	}
+
+	//uniformly distributed in [0, bound) -- unlike "% bound", which favors small values when bound doesn't divide 2^32:
+	// (Lemire's multiply-and-reject; it only draws again for a tiny fraction of values)
+	uint32_t below(uint32_t bound) {
+		assert(bound > 0);
+		uint64_t m = uint64_t((*this)()) * bound;
+		uint32_t low = uint32_t(m);
+		if (low < bound) {
+			uint32_t threshold = (0U - bound) % bound; //(2^32 mod bound)
+			while (low < threshold) {
+				m = uint64_t((*this)()) * bound;
+				low = uint32_t(m);
+			}
+		}
+		return uint32_t(m >> 32);
+	}
+
+	//uniformly distributed in [0, 1):
+	float unit() {
+		return float((*this)() >> 8) * (1.0f / 16777216.0f);
+	}
+	//uniformly distributed in [min, max):
+	float uniform(float min_, float max_) {
+		return min_ + (max_ - min_) * unit();
+	}
+
+	//fill 'out' with 'count' values (e.g., everything a batch of spawns needs, drawn up front):
+	void fill(uint32_t *out, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			out[i] = (*this)();
+		}
+	}
+	void fill_below(uint32_t bound, uint32_t *out, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			out[i] = below(bound);
+		}
+	}
+
+	//a new generator, seeded from this one, on stream 'stream' (to give a subsystem a sequence of its own):
+	PCG32 split(uint64_t stream) {
+		uint64_t high = (*this)();
+		uint64_t low = (*this)();
+		return PCG32((high << 32) | low, stream);
+	}
+
+	uint64_t state = 0x853c49e6748fea9bULL;
+	uint64_t inc = 0xda3e39cb94b95bdbULL;
+};
@@ -0,0 +1,315 @@
+#include "shader_files.hpp"
+
+#include "compile_program.hpp"
+#include "data_path.hpp"
+#include "gl_errors.hpp"
+
+#include <SDL.h>
+
+#include <list>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+//read data_path("shaders/" + name), expanding '#include "file"' lines:
+static std::string read_shader(std::string const &name, uint32_t depth = 0) {
+	if (depth > 8) {
+		throw std::runtime_error("Shader includes nested too deeply at '" + name + "'.");
+	}
+	std::ifstream file(data_path("shaders/" + name), std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open shader file '" + name + "'.");
+	}
+	std::string source;
+	std::string line;
+	while (std::getline(file, line)) {
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		std::string::size_type at = line.find_first_not_of(" \t");
+		if (at != std::string::npos && line.compare(at, 8, "#include") == 0) {
+			std::string::size_type open = line.find('"', at + 8);
+			std::string::size_type close = (open == std::string::npos ? open : line.find('"', open + 1));
+			if (close == std::string::npos) {
+				throw std::runtime_error("Malformed #include in shader file '" + name + "'.");
+			}
+			source += read_shader(line.substr(open + 1, close - open - 1), depth + 1);
+		} else {
+			source += line;
+			source += '\n';
+		}
+	}
+	return source;
+}
+
+//------------------------------------------
+
+struct WatchedProgram {
+	GLuint *program = nullptr;
+	std::string vertex_file;
+	std::string fragment_file;
+	std::function< void(GLuint) > setup;
+	std::vector< std::string > feedback_varyings;
+
+	std::string vertex_source; //sources of the most recent build (or attempted build)
+	std::string fragment_source;
+
+	bool check = false; //files may have changed since the last build started
+	GLuint pending = 0; //program being rebuilt, if any
+};
+
+static std::list< WatchedProgram > watched;
+
+//KHR_parallel_shader_compile (or the ARB version) lets the driver compile+link on its own threads;
+// GL_COMPLETION_STATUS can then be polled without waiting:
+struct ParallelCompile {
+	bool available = false;
+
+	ParallelCompile() {
+		bool khr = false;
+		bool arb = false;
+		GLint extensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+		for (GLint i = 0; i < extensions; ++i) {
+			char const *name = reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, i));
+			if (!name) continue;
+			if (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0) khr = true;
+			if (std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0) arb = true;
+		}
+
+		PFNGLMAXSHADERCOMPILERTHREADSARBPROC MaxShaderCompilerThreads = nullptr;
+		if (khr) {
+			MaxShaderCompilerThreads = reinterpret_cast< PFNGLMAXSHADERCOMPILERTHREADSARBPROC >(SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsKHR"));
+		} else if (arb) {
+			MaxShaderCompilerThreads = reinterpret_cast< PFNGLMAXSHADERCOMPILERTHREADSARBPROC >(SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsARB"));
+		}
+		if (!MaxShaderCompilerThreads) return;
+
+		MaxShaderCompilerThreads(0xFFFFFFFF); //(let the driver pick the number of threads)
+		available = true;
+	}
+};
+
+static ParallelCompile &parallel_compile() {
+	static ParallelCompile parallel; //(first use is well after the GL context exists)
+	return parallel;
+}
+
+//ShaderWatcher reports when files in the shader directory may have changed:
+// on Linux it listens for inotify events; elsewhere it just says "maybe" about once a second
+// (the sources are compared with the last build before anything is recompiled, so this is cheap).
+struct ShaderWatcher {
+	bool enabled = true;
+#ifdef __linux__
+	int fd = -1;
+#endif
+	std::chrono::steady_clock::time_point next_poll = std::chrono::steady_clock::now();
+
+	ShaderWatcher() {
+		if (std::getenv("NO_SHADER_RELOAD")) {
+			enabled = false;
+			return;
+		}
+#ifdef __linux__
+		fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (fd >= 0 && inotify_add_watch(fd, data_path("shaders").c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+			std::cerr << "Note: couldn't watch shader directory; polling for changes instead." << std::endl;
+			close(fd);
+			fd = -1;
+		}
+#endif
+	}
+
+	~ShaderWatcher() {
+#ifdef __linux__
+		if (fd >= 0) close(fd);
+#endif
+	}
+
+	bool changed() {
+		if (!enabled) return false;
+#ifdef __linux__
+		if (fd >= 0) {
+			bool any = false;
+			alignas(inotify_event) char buffer[4096];
+			while (read(fd, buffer, sizeof(buffer)) > 0) {
+				any = true; //(which file changed doesn't matter -- it may be #include'd anywhere)
+			}
+			return any;
+		}
+#endif
+		auto now = std::chrono::steady_clock::now();
+		if (now < next_poll) return false;
+		next_poll = now + std::chrono::seconds(1);
+		return true;
+	}
+};
+
+//re-read sources and, if they differ from the last build, start compiling+linking a new program:
+static void start_rebuild(WatchedProgram &w) {
+	std::string vertex_source, fragment_source;
+	try {
+		vertex_source = read_shader(w.vertex_file);
+		fragment_source = read_shader(w.fragment_file);
+	} catch (std::exception &e) {
+		std::cerr << "Not reloading '" << w.vertex_file << "' + '" << w.fragment_file << "': " << e.what() << std::endl;
+		return;
+	}
+	if (vertex_source == w.vertex_source && fragment_source == w.fragment_source) return;
+	w.vertex_source = vertex_source;
+	w.fragment_source = fragment_source;
+
+	parallel_compile(); //(sets up compiler threads before the first rebuild)
+
+	GLuint program = glCreateProgram();
+	auto attach = [&program](GLenum type, std::string const &source) {
+		GLuint shader = glCreateShader(type);
+		GLchar const *str = source.c_str();
+		GLint length = GLint(source.size());
+		glShaderSource(shader, 1, &str, &length);
+		glCompileShader(shader);
+		glAttachShader(program, shader);
+		glDeleteShader(shader); //(freed along with the program)
+	};
+	attach(GL_VERTEX_SHADER, vertex_source);
+	attach(GL_FRAGMENT_SHADER, fragment_source);
+
+	//keep attribute locations the same as the old program, so vertex array objects made for it still work:
+	GLint attributes = 0;
+	GLint max_length = 0;
+	glGetProgramiv(*w.program, GL_ACTIVE_ATTRIBUTES, &attributes);
+	glGetProgramiv(*w.program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+	std::vector< GLchar > name(std::max(max_length, 1), 0);
+	for (GLint i = 0; i < attributes; ++i) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveAttrib(*w.program, GLuint(i), GLsizei(name.size()), &length, &size, &type, name.data());
+		std::string attribute(name.data(), name.data() + length);
+		if (attribute.compare(0, 3, "gl_") == 0) continue;
+		GLint location = glGetAttribLocation(*w.program, attribute.c_str());
+		if (location >= 0) glBindAttribLocation(program, GLuint(location), attribute.c_str());
+	}
+
+	if (!w.feedback_varyings.empty()) {
+		std::vector< GLchar const * > names;
+		for (auto const &varying : w.feedback_varyings) {
+			names.emplace_back(varying.c_str());
+		}
+		glTransformFeedbackVaryings(program, GLsizei(names.size()), names.data(), GL_INTERLEAVED_ATTRIBS);
+	}
+
+	//(compile errors show up as a failed link; with parallel compile this returns right away)
+	glLinkProgram(program);
+	w.pending = program;
+	GL_ERRORS();
+}
+
+static void print_log(std::string const &what, std::vector< GLchar > const &log, GLsizei length) {
+	if (length <= 0) return;
+	std::cerr << what << ":\n" << std::string(log.begin(), log.begin() + length);
+}
+
+//swap in the pending program if it linked, otherwise report why not:
+static void finish_rebuild(WatchedProgram &w) {
+	GLuint program = w.pending;
+	w.pending = 0;
+
+	GLint link_status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+	if (link_status != GL_TRUE) {
+		std::cerr << "Failed to rebuild program from '" << w.vertex_file << "' + '" << w.fragment_file << "'; keeping the old version." << std::endl;
+		GLuint shaders[2] = {0, 0};
+		GLsizei count = 0;
+		glGetAttachedShaders(program, 2, &count, shaders);
+		for (GLsizei i = 0; i < count; ++i) {
+			GLint log_length = 0;
+			glGetShaderiv(shaders[i], GL_INFO_LOG_LENGTH, &log_length);
+			std::vector< GLchar > log(std::max(log_length, 1), 0);
+			GLsizei length = 0;
+			glGetShaderInfoLog(shaders[i], GLsizei(log.size()), &length, log.data());
+			GLint type = 0;
+			glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type);
+			print_log(type == GL_VERTEX_SHADER ? w.vertex_file : w.fragment_file, log, length);
+		}
+		GLint log_length = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_length);
+		std::vector< GLchar > log(std::max(log_length, 1), 0);
+		GLsizei length = 0;
+		glGetProgramInfoLog(program, GLsizei(log.size()), &length, log.data());
+		print_log("link", log, length);
+		glDeleteProgram(program);
+		return;
+	}
+
+	//everything drawn from here on uses the new program:
+	GLuint old = *w.program;
+	*w.program = program;
+	if (w.setup) w.setup(program);
+	glDeleteProgram(old);
+	GL_ERRORS();
+
+	std::cout << "Reloaded '" << w.vertex_file << "' + '" << w.fragment_file << "'." << std::endl;
+}
+
+//------------------------------------------
+
+void load_program_files(
+	GLuint *program,
+	std::string const &vertex_file,
+	std::string const &fragment_file,
+	std::function< void(GLuint) > const &setup,
+	std::vector< std::string > const &feedback_varyings) {
+
+	std::string vertex_source = read_shader(vertex_file);
+	std::string fragment_source = read_shader(fragment_file);
+	*program = compile_program(vertex_source, fragment_source, feedback_varyings);
+	if (setup) setup(*program);
+
+	watched.emplace_back();
+	WatchedProgram &w = watched.back();
+	w.program = program;
+	w.vertex_file = vertex_file;
+	w.fragment_file = fragment_file;
+	w.setup = setup;
+	w.feedback_varyings = feedback_varyings;
+	w.vertex_source = vertex_source;
+	w.fragment_source = fragment_source;
+}
+
+void reload_changed_programs() {
+	static ShaderWatcher watcher;
+	if (!watcher.enabled) return;
+
+	if (watcher.changed()) {
+		for (auto &w : watched) {
+			w.check = true;
+		}
+	}
+
+	for (auto &w : watched) {
+		if (w.pending) {
+			//don't stall waiting on the driver's compiler threads; check back next frame:
+			//(without the extension, link status queries just wait for the link to finish)
+			if (parallel_compile().available) {
+				GLint done = GL_FALSE;
+				glGetProgramiv(w.pending, GL_COMPLETION_STATUS_ARB, &done);
+				if (done != GL_TRUE) continue;
+			}
+			finish_rebuild(w);
+		}
+		if (w.check) {
+			//(a file changed while a rebuild was pending waits until that rebuild finishes)
+			w.check = false;
+			start_rebuild(w);
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <string>
+#include <vector>
+#include <functional>
+
+//Shader programs whose sources live in dist/shaders (found with data_path("shaders/...")).
+// Source files may paste in other files from the same directory with a line like:
+//   #include "object_block.glsl"
+
+//build '*program' from the named vertex and fragment shader files (via compile_program, so the
+// program binary cache still applies), then call 'setup' -- which should look up uniform locations,
+// set sampler units, and so on. Throws if the program fails to build.
+//'feedback_varyings' (if any) are captured by transform feedback, as in compile_program.
+//
+//'*program' is then watched: when one of its files changes, the program is rebuilt in the background;
+// if the new version links, '*program' is swapped to it (between frames), 'setup' is called with it,
+// and the old program is deleted. A failed rebuild prints its logs and keeps the old program.
+//Attribute locations are carried over from the old program, so existing vertex array objects stay valid.
+//
+//set NO_SHADER_RELOAD in the environment to skip watching.
+void load_program_files(
+	GLuint *program,
+	std::string const &vertex_file,
+	std::string const &fragment_file,
+	std::function< void(GLuint) > const &setup = nullptr,
+	std::vector< std::string > const &feedback_varyings = std::vector< std::string >());
+
+//look for changed shader files and advance any rebuilds in progress;
+// call once per frame, outside of any drawing:
+void reload_changed_programs();
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+//SPSCQueue is a fixed-size queue for handing values from one thread (the only one calling push)
+// to another (the only one calling pop) without locks.
+//Slots are reused, so values that own memory (e.g., vectors) stop allocating once the queue warms up.
+template< typename T, uint32_t Size >
+struct SPSCQueue {
+	static_assert(Size > 0 && (Size & (Size - 1)) == 0, "SPSCQueue size must be a power of two.");
+
+	//copy 'value' into the queue; returns false (and does nothing) if the queue is full:
+	bool push(T const &value) {
+		uint32_t h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) == Size) return false;
+		slots[h & (Size - 1)] = value;
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	//swap the oldest value into '*value'; returns false if the queue is empty:
+	// (the slot gets *value's old contents, so its memory can be reused by a later push)
+	bool pop(T *value) {
+		uint32_t t = tail.load(std::memory_order_relaxed);
+		if (head.load(std::memory_order_acquire) == t) return false;
+		std::swap(*value, slots[t & (Size - 1)]);
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	//internals:
+	T slots[Size];
+	std::atomic< uint32_t > head{0}; //count of values pushed (only written by the pushing thread)
+	std::atomic< uint32_t > tail{0}; //count of values popped (only written by the popping thread)
+};
@@ -0,0 +1,90 @@
+#include "uniform_blocks.hpp"
+
+#include "Load.hpp"
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+void bind_uniform_blocks(GLuint program) {
+	GLuint lighting = glGetUniformBlockIndex(program, "Lighting");
+	if (lighting != GL_INVALID_INDEX) glUniformBlockBinding(program, lighting, LightingBinding);
+	GLuint object = glGetUniformBlockIndex(program, "Object");
+	if (object != GL_INVALID_INDEX) glUniformBlockBinding(program, object, ObjectBinding);
+	GL_ERRORS();
+}
+
+//------------------------------------------
+
+UniformRing::UniformRing(GLsizeiptr size_) : size(size_) {
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	alignment = std::max(alignment, 1);
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	GL_ERRORS();
+}
+
+UniformRing::~UniformRing() {
+	glDeleteBuffers(1, &buffer);
+}
+
+GLsizeiptr UniformRing::stride(GLsizeiptr block_size) const {
+	return (block_size + alignment - 1) / alignment * alignment;
+}
+
+GLintptr UniformRing::push(void const *data, GLsizeiptr bytes) {
+	head = stride(head);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	if (head + bytes > size) {
+		//grow if this is more than the whole buffer holds:
+		while (bytes > size) size *= 2;
+		//orphan: in-flight draws keep the old storage, and everything after this writes to fresh storage:
+		glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_STREAM_DRAW);
+		head = 0;
+		orphans += 1;
+	}
+
+	//(nothing queued so far reads [head, head+bytes) of the current storage, so no need to synchronize)
+	void *dst = glMapBufferRange(GL_UNIFORM_BUFFER, head, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (!dst) {
+		throw std::runtime_error("Failed to map uniform buffer.");
+	}
+	std::memcpy(dst, data, bytes);
+	glUnmapBuffer(GL_UNIFORM_BUFFER);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	GLintptr at = head;
+	head += bytes;
+	return at;
+}
+
+//------------------------------------------
+
+UniformRing &object_blocks() {
+	//room for a few hundred objects before the first orphan:
+	// (like Load<>'ed resources, this lives until the program exits)
+	static UniformRing *ring = new UniformRing(256 * 1024);
+	return *ring;
+}
+
+Load< GLuint > lighting_buffer(LoadTagInit, [](){
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightingBlock), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	GL_ERRORS();
+	return new GLuint(buffer);
+});
+
+void upload_lighting(LightingBlock const &lighting) {
+	glBindBuffer(GL_UNIFORM_BUFFER, *lighting_buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightingBlock), &lighting);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, LightingBinding, *lighting_buffer);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+//Uniform blocks shared by the scene's programs.
+// "Lighting" holds state that is the same for every object, and is uploaded once per frame.
+// "Object" holds per-object matrices and material parameters; Scene::draw writes these for
+// a whole pass into object_blocks() (below) and selects each object's block with glBindBufferRange.
+//
+//The structs below mirror the std140 layout of the GLSL declarations in dist/shaders/lighting_block.glsl
+// and dist/shaders/object_block.glsl (vec3 and matrix columns pad to 16 bytes).
+
+enum : GLuint {
+	LightingBinding = 0,
+	ObjectBinding = 1,
+};
+
+struct LightingBlock {
+	glm::vec3 sun_direction = glm::vec3(0.0f, 0.0f, 1.0f); float pad0; //direction *to* sun
+	glm::vec3 sun_color = glm::vec3(0.0f); float pad1;
+	glm::vec3 sky_direction = glm::vec3(0.0f, 0.0f, 1.0f); float pad2; //direction *to* sky
+	glm::vec3 sky_color = glm::vec3(0.0f); float pad3;
+	glm::vec3 spot_position = glm::vec3(0.0f); float pad4;
+	glm::vec3 spot_direction = glm::vec3(0.0f, 0.0f,-1.0f); float pad5; //direction *from* spotlight
+	glm::vec3 spot_color = glm::vec3(0.0f); float pad6;
+	glm::vec2 spot_outer_inner = glm::vec2(0.0f, 1.0f); float pad7[2]; //spot fades in as dot(spot_direction, spot_to_position) goes from x to y
+	glm::mat4 light_to_spot = glm::mat4(1.0f); //lighting (world) space to spot light depth map space
+};
+static_assert(sizeof(LightingBlock) == 192, "LightingBlock should match std140 layout of Lighting");
+
+struct ObjectBlock {
+	glm::mat4 object_to_clip;
+	glm::vec4 object_to_light[4]; //mat4x3 (std140 pads each column to a vec4)
+	glm::vec4 normal_to_light[3]; //mat3 (same padding)
+	float glow_amt; float pad[3];
+};
+static_assert(sizeof(ObjectBlock) == 192, "ObjectBlock should match std140 layout of Object");
+
+//connect whichever of the above blocks 'program' uses to their binding points:
+void bind_uniform_blocks(GLuint program);
+
+//UniformRing hands out space in a uniform buffer for data that changes every draw.
+// Data is written with unsynchronized glMapBufferRange calls at a moving 'head';
+// when the buffer fills up it is orphaned (glBufferData with NULL) and writing starts over,
+// so the driver never has to wait on draws that still read older data.
+struct UniformRing {
+	UniformRing(GLsizeiptr size);
+	~UniformRing();
+
+	//distance between consecutive blocks of 'block_size' bytes (rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT):
+	GLsizeiptr stride(GLsizeiptr block_size) const;
+
+	//copy 'bytes' bytes into the buffer; returns the (suitably aligned) offset they were written at:
+	GLintptr push(void const *data, GLsizeiptr bytes);
+
+	GLuint buffer = 0;
+	GLsizeiptr size = 0;
+	GLsizeiptr head = 0;
+	GLint alignment = 256;
+	uint32_t orphans = 0; //how many times the buffer has wrapped
+};
+
+//per-object blocks for Scene::draw (created on first use):
+UniformRing &object_blocks();
+
+//write the per-frame lighting block:
+void upload_lighting(LightingBlock const &lighting);